@@ -70,6 +70,13 @@ Revision: $Rev: 21386 $
 //#define SEGGER_RTT_CPU_CACHE_LINE_SIZE            (32)          // Largest cache line size (in bytes) in the current system
 //#define SEGGER_RTT_UNCACHED_OFF                   (0xFB000000)  // Address alias where RTT CB and buffers can be accessed uncached
 //
+// The control block and buffers are in RAM_D2, which the MPU makes non-cacheable (see common/cache.h),
+// so the cache line size above stays 0.  The section is cleared by the startup code.
+//
+#ifndef   SEGGER_RTT_SECTION
+  #define SEGGER_RTT_SECTION                        ".bss_d2"
+#endif
+//
 // Most common case:
 // Up-channel 0: RTT
 // Up-channel 1: SystemView
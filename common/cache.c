@@ -0,0 +1,141 @@
+/**
+  ******************************************************************************
+  * File Name          : cache.c
+  * Description        : This file implements an API for the L1 caches and the
+  *                      MPU of the Cortex-M7 core.
+  */
+
+#include "cache.h"
+
+#include "stm32h7xx_hal.h"
+
+/**@brief   The base address of RAM_D2, see STM32H723ZGTX_FLASH.ld.
+ */
+#define RAM_D2_BASE             0x30000000
+
+/**@brief   The base address of RAM_D3, see STM32H723ZGTX_FLASH.ld.
+ */
+#define RAM_D3_BASE             0x38000000
+
+/**@brief   The regions of the MPU, see cache.h.  A region overrides the
+ *          regions before it.
+ */
+static const MPU_Region_InitTypeDef m_regions[] =
+{
+    {
+        // The whole address space, only the subregions from 0x60000000 to
+        // 0xDFFFFFFF are enabled
+        .Enable = MPU_REGION_ENABLE,
+        .Number = MPU_REGION_NUMBER0,
+        .BaseAddress = 0x00000000,
+        .Size = MPU_REGION_SIZE_4GB,
+        .SubRegionDisable = 0x87,
+        .TypeExtField = MPU_TEX_LEVEL0,
+        .AccessPermission = MPU_REGION_NO_ACCESS,
+        .DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE,
+        .IsShareable = MPU_ACCESS_SHAREABLE,
+        .IsCacheable = MPU_ACCESS_NOT_CACHEABLE,
+        .IsBufferable = MPU_ACCESS_NOT_BUFFERABLE,
+    },
+    {
+        // The peripherals, shareable device
+        .Enable = MPU_REGION_ENABLE,
+        .Number = MPU_REGION_NUMBER1,
+        .BaseAddress = PERIPH_BASE,
+        .Size = MPU_REGION_SIZE_512MB,
+        .SubRegionDisable = 0x00,
+        .TypeExtField = MPU_TEX_LEVEL0,
+        .AccessPermission = MPU_REGION_FULL_ACCESS,
+        .DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE,
+        .IsShareable = MPU_ACCESS_SHAREABLE,
+        .IsCacheable = MPU_ACCESS_NOT_CACHEABLE,
+        .IsBufferable = MPU_ACCESS_BUFFERABLE,
+    },
+    {
+        // RAM_D2, normal, not cacheable
+        .Enable = MPU_REGION_ENABLE,
+        .Number = MPU_REGION_NUMBER2,
+        .BaseAddress = RAM_D2_BASE,
+        .Size = MPU_REGION_SIZE_32KB,
+        .SubRegionDisable = 0x00,
+        .TypeExtField = MPU_TEX_LEVEL1,
+        .AccessPermission = MPU_REGION_FULL_ACCESS,
+        .DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE,
+        .IsShareable = MPU_ACCESS_SHAREABLE,
+        .IsCacheable = MPU_ACCESS_NOT_CACHEABLE,
+        .IsBufferable = MPU_ACCESS_NOT_BUFFERABLE,
+    },
+    {
+        // RAM_D3, normal, write-through and no write allocate
+        .Enable = MPU_REGION_ENABLE,
+        .Number = MPU_REGION_NUMBER3,
+        .BaseAddress = RAM_D3_BASE,
+        .Size = MPU_REGION_SIZE_16KB,
+        .SubRegionDisable = 0x00,
+        .TypeExtField = MPU_TEX_LEVEL0,
+        .AccessPermission = MPU_REGION_FULL_ACCESS,
+        .DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE,
+        .IsShareable = MPU_ACCESS_NOT_SHAREABLE,
+        .IsCacheable = MPU_ACCESS_CACHEABLE,
+        .IsBufferable = MPU_ACCESS_NOT_BUFFERABLE,
+    },
+};
+
+
+void cache_init(void)
+{
+#if CACHE_ENABLE
+    MPU_Region_InitTypeDef region;
+
+    HAL_MPU_Disable();
+
+    for (size_t i = 0; i < (sizeof(m_regions) / sizeof(m_regions[0])); i++)
+    {
+        // HAL_MPU_ConfigRegion() doesn't take a const pointer
+        region = m_regions[i];
+        HAL_MPU_ConfigRegion(&region);
+    }
+
+    // The default memory map applies outside of the regions
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+    SCB_EnableICache();
+    SCB_EnableDCache();
+#endif  // CACHE_ENABLE
+}
+
+
+void cache_clean(const void *p_addr, size_t size)
+{
+#if CACHE_ENABLE
+    // The CMSIS functions round the range out to whole lines
+    SCB_CleanDCache_by_Addr((uint32_t *)(uintptr_t)p_addr, (int32_t)size);
+#else
+    (void)p_addr;
+    (void)size;
+#endif  // CACHE_ENABLE
+}
+
+
+void cache_invalidate(void *p_addr, size_t size)
+{
+#if CACHE_ENABLE
+    SCB_InvalidateDCache_by_Addr(p_addr, (int32_t)size);
+#else
+    (void)p_addr;
+    (void)size;
+#endif  // CACHE_ENABLE
+}
+
+
+void cache_clean_invalidate(void *p_addr, size_t size)
+{
+#if CACHE_ENABLE
+    SCB_CleanInvalidateDCache_by_Addr((uint32_t *)p_addr, (int32_t)size);
+#else
+    (void)p_addr;
+    (void)size;
+#endif  // CACHE_ENABLE
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
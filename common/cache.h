@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * File Name          : cache.h
+  * Description        : This file provides an API for the L1 caches and the
+  *                      MPU of the Cortex-M7 core.
+  *
+  * cache_init() sets the memory attributes with the MPU, then enables the
+  * instruction and data caches.  The regions are:
+  *
+  *  - 0x60000000 to 0xDFFFFFFF, the external memories, no access.  Nothing
+  *    is mapped there yet, and the region stops speculative reads of the
+  *    core from reaching the FMC and OCTOSPI.
+  *
+  *  - 0x40000000 to 0x5FFFFFFF, the peripherals, shareable device memory.
+  *    This is the default memory map, made explicit.
+  *
+  *  - RAM_D2, shareable and not cacheable.  It holds the .dma_buffer section
+  *    and the RTT control block and buffers, read by DMA and the debug probe
+  *    behind the back of the core.  Nothing in RAM_D2 needs cache
+  *    maintenance.
+  *
+  *  - RAM_D3, write-through.  It holds the log of the previous boot, which
+  *    must be in the RAM when a reset discards the dirty lines of the cache.
+  *
+  * The rest of the memory map keeps its default attributes: the flash is
+  * write-through, RAM_D1 is write-back and the TCMs aren't cached.
+  *
+  * A buffer that is read or written by DMA and isn't in RAM_D2 needs the
+  * cache_clean() and cache_invalidate() calls around each transfer.
+  */
+
+#ifndef __X_CACHE_H
+#define __X_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**@brief   Set to 0 to leave the caches and the MPU disabled, e.g. to find a
+ *          missing cache maintenance call.
+ */
+#ifndef CACHE_ENABLE
+#define CACHE_ENABLE            1
+#endif  // CACHE_ENABLE
+
+/**@brief   The size of a line of the data cache of the Cortex-M7, in bytes.
+ */
+#define CACHE_LINE_SIZE         32
+
+/**@brief   Align a DMA buffer on a cache line.
+ *
+ * The size of the buffer must also be a multiple of CACHE_LINE_SIZE, so
+ * invalidating it can't discard a variable that shares its last line.
+ */
+#define CACHE_ALIGNED           __attribute__((aligned(CACHE_LINE_SIZE)))
+
+
+/**@brief   Configure the MPU and enable the instruction and data caches.
+ *
+ * Must be called first thing in main(), before anything is written to
+ * RAM_D2 or RAM_D3.
+ */
+void cache_init(void);
+
+/**@brief   Write the cached data of a buffer to the RAM.
+ *
+ * Call before a DMA transfer reads the buffer.
+ *
+ * @param[in]   p_addr  The start of the buffer.
+ * @param[in]   size    The size of the buffer, in bytes.
+ */
+void cache_clean(const void *p_addr, size_t size);
+
+/**@brief   Discard the cached data of a buffer.
+ *
+ * Call after a DMA transfer has written the buffer, before reading it.  The
+ * whole lines are discarded, so the buffer must be CACHE_ALIGNED.
+ *
+ * @param[in]   p_addr  The start of the buffer.
+ * @param[in]   size    The size of the buffer, in bytes.
+ */
+void cache_invalidate(void *p_addr, size_t size);
+
+/**@brief   Write the cached data of a buffer to the RAM, then discard it.
+ *
+ * Call before a DMA transfer writes a buffer that the core may also have
+ * written, so a dirty line can't be evicted over the data of the transfer.
+ *
+ * @param[in]   p_addr  The start of the buffer.
+ * @param[in]   size    The size of the buffer, in bytes.
+ */
+void cache_clean_invalidate(void *p_addr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_CACHE_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,31 @@
+/**
+  ******************************************************************************
+  * File Name          : cycles.c
+  * Description        : This file implements an API for the DWT cycle counter
+  *                      of the Cortex-M core.
+  */
+
+#include "cycles.h"
+
+/**@brief   The value written to the DWT lock access register to allow writes
+ *          to the other DWT registers.
+ */
+#define DWT_LAR_UNLOCK          0xC5ACCE55
+
+
+void cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = DWT_LAR_UNLOCK;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+uint32_t cycles_to_us(uint32_t cycles)
+{
+    return cycles / (SystemCoreClock / 1000000);
+}
+
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : cycles.h
+  * Description        : This file provides an API for the DWT cycle counter
+  *                      of the Cortex-M core.
+  *
+  * The counter runs at the core clock and is used to timestamp log records
+  * and to measure short sections of code.  It wraps around after 2^32 cycles,
+  * about 7.8 seconds at 550 MHz.
+  */
+
+#ifndef __X_CYCLES_H
+#define __X_CYCLES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "stm32h7xx.h"
+
+/**@brief   Enable the cycle counter and reset it to 0.
+ *
+ * The counter is also used by the debugger, so this function only changes
+ * the bits it needs.
+ */
+void cycles_init(void);
+
+/**@brief   Get the current value of the cycle counter.
+ *
+ * @return  The number of core clock cycles since cycles_init() was called,
+ *          modulo 2^32.
+ */
+static inline uint32_t cycles_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**@brief   Convert a number of cycles to microseconds.
+ *
+ * @param[in]   cycles  The number of cycles to convert.
+ *
+ * @return  The number of microseconds at the current core clock.
+ */
+uint32_t cycles_to_us(uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_CYCLES_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * File Name          : cache.c
+  * Description        : This file replaces the cache API in the host build.
+  *
+  * The caches of the host are coherent and there's no MPU, so every function
+  * does nothing.
+  */
+
+#include "cache.h"
+
+
+void cache_init(void)
+{
+}
+
+
+void cache_clean(const void *p_addr, size_t size)
+{
+    (void)p_addr;
+    (void)size;
+}
+
+
+void cache_invalidate(void *p_addr, size_t size)
+{
+    (void)p_addr;
+    (void)size;
+}
+
+
+void cache_clean_invalidate(void *p_addr, size_t size)
+{
+    (void)p_addr;
+    (void)size;
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,339 @@
+/**
+  ******************************************************************************
+  * File Name          : cmsis_os.c
+  * Description        : This file implements the part of the CMSIS-RTOS2 API
+  *                      used by the common library on top of POSIX threads.
+  *
+  * One mutex protects the kernel state and the thread flags, and one
+  * condition variable is broadcast whenever either changes.  That's slow
+  * with many threads but the host build only has a few.
+  *
+  * Threads created before osKernelStart() wait for it, like the FreeRTOS
+  * tasks created from main().  The thread control blocks are never freed, so
+  * an ID stays valid after its thread exits.
+  */
+
+#define _POSIX_C_SOURCE         200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cmsis_os.h"
+
+/**@brief   The tick rate, the same as configTICK_RATE_HZ on the target.
+ */
+#define TICK_FREQ               1000
+
+/**@brief   The control block of a thread.
+ */
+typedef struct
+{
+    pthread_t thread;           /**< The POSIX thread. */
+    osThreadFunc_t func;        /**< The function of the thread. */
+    void *argument;             /**< The argument of func. */
+    const char *name;           /**< The name, may be NULL. */
+    uint32_t flags;             /**< The thread flags. */
+} host_thread_t;
+
+/**@brief   Protects the variables below and the flags of every thread. */
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**@brief   Broadcast when the kernel state or the flags of a thread change. */
+static pthread_cond_t m_changed;
+
+/**@brief   Initializes m_changed and m_start once. */
+static pthread_once_t m_once = PTHREAD_ONCE_INIT;
+
+/**@brief   The time of the first call, tick 0. */
+static struct timespec m_start;
+
+/**@brief   The state returned by osKernelGetState(), without the lock. */
+static osKernelState_t m_state = osKernelInactive;
+
+/**@brief   Set by osKernelLock(). */
+static bool m_locked = false;
+
+/**@brief   The thread running, NULL for the thread of main(). */
+static __thread host_thread_t *m_current;
+
+
+/**@brief   Internal function used to initialize the module on first use.
+ *
+ * The condition variable uses the monotonic clock so the timeouts don't
+ * depend on the time of day.
+ */
+static void _init(void)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_changed, &attr);
+    pthread_condattr_destroy(&attr);
+
+    clock_gettime(CLOCK_MONOTONIC, &m_start);
+}
+
+
+/**@brief   Internal function used to get the deadline of a timeout.
+ *
+ * @param[out]  p_deadline  Set to the monotonic time ticks from now.
+ * @param[in]   ticks       The timeout in ticks.
+ */
+static void _deadline(struct timespec *p_deadline, uint32_t ticks)
+{
+    uint64_t ns = (uint64_t)ticks * (1000000000 / TICK_FREQ);
+
+    clock_gettime(CLOCK_MONOTONIC, p_deadline);
+    ns += p_deadline->tv_nsec;
+    p_deadline->tv_sec += ns / 1000000000;
+    p_deadline->tv_nsec = ns % 1000000000;
+}
+
+
+/**@brief   Internal function used to start a thread once the kernel runs.
+ *
+ * @param[in]   argument    The control block of the thread.
+ *
+ * @return  Doesn't return, the thread function must call osThreadExit().
+ */
+static void *_thread_main(void *argument)
+{
+    host_thread_t *p_thread = argument;
+
+    m_current = p_thread;
+
+    pthread_mutex_lock(&m_lock);
+    while (osKernelInactive == m_state || osKernelReady == m_state)
+    {
+        pthread_cond_wait(&m_changed, &m_lock);
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    p_thread->func(p_thread->argument);
+
+    // Returning from a FreeRTOS task is an error, end the thread anyway
+    osThreadExit();
+}
+
+
+osStatus_t osKernelInitialize(void)
+{
+    pthread_once(&m_once, _init);
+
+    pthread_mutex_lock(&m_lock);
+    m_state = osKernelReady;
+    pthread_mutex_unlock(&m_lock);
+
+    return osOK;
+}
+
+
+osKernelState_t osKernelGetState(void)
+{
+    osKernelState_t state;
+
+    pthread_mutex_lock(&m_lock);
+    state = (m_locked && (osKernelRunning == m_state)) ? osKernelLocked : m_state;
+    pthread_mutex_unlock(&m_lock);
+
+    return state;
+}
+
+
+osStatus_t osKernelStart(void)
+{
+    pthread_once(&m_once, _init);
+
+    pthread_mutex_lock(&m_lock);
+    m_state = osKernelRunning;
+    pthread_cond_broadcast(&m_changed);
+    pthread_mutex_unlock(&m_lock);
+
+    // Like the scheduler, don't return.  The process ends when a thread
+    // calls exit() or every thread has exited.
+    pthread_exit(NULL);
+}
+
+
+int32_t osKernelLock(void)
+{
+    int32_t lock;
+
+    pthread_mutex_lock(&m_lock);
+    lock = m_locked ? 1 : 0;
+    m_locked = true;
+    pthread_mutex_unlock(&m_lock);
+
+    return lock;
+}
+
+
+int32_t osKernelUnlock(void)
+{
+    return osKernelRestoreLock(0);
+}
+
+
+int32_t osKernelRestoreLock(int32_t lock)
+{
+    int32_t previous;
+
+    pthread_mutex_lock(&m_lock);
+    previous = m_locked ? 1 : 0;
+    m_locked = (0 != lock);
+    pthread_mutex_unlock(&m_lock);
+
+    return previous;
+}
+
+
+uint32_t osKernelGetTickCount(void)
+{
+    struct timespec now;
+
+    pthread_once(&m_once, _init);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((now.tv_sec - m_start.tv_sec) * TICK_FREQ +
+                      (now.tv_nsec - m_start.tv_nsec) / (1000000000 / TICK_FREQ));
+}
+
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return TICK_FREQ;
+}
+
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
+{
+    host_thread_t *p_thread;
+
+    if (NULL == func)
+    {
+        return NULL;
+    }
+
+    pthread_once(&m_once, _init);
+
+    p_thread = calloc(1, sizeof(*p_thread));
+    if (NULL == p_thread)
+    {
+        return NULL;
+    }
+
+    p_thread->func = func;
+    p_thread->argument = argument;
+    p_thread->name = (NULL != attr) ? attr->name : NULL;
+
+    // The stack size of the attributes is for the target, use the default
+    if (0 != pthread_create(&p_thread->thread, NULL, _thread_main, p_thread))
+    {
+        free(p_thread);
+        return NULL;
+    }
+    pthread_detach(p_thread->thread);
+
+    return p_thread;
+}
+
+
+osThreadId_t osThreadGetId(void)
+{
+    return m_current;
+}
+
+
+void osThreadExit(void)
+{
+    pthread_exit(NULL);
+}
+
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    host_thread_t *p_thread = thread_id;
+    uint32_t result;
+
+    if ((NULL == p_thread) || (0 != (flags & osFlagsError)))
+    {
+        return osFlagsErrorParameter;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    p_thread->flags |= flags;
+    result = p_thread->flags;
+    pthread_cond_broadcast(&m_changed);
+    pthread_mutex_unlock(&m_lock);
+
+    return result;
+}
+
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    host_thread_t *p_thread = m_current;
+    struct timespec deadline;
+    uint32_t result;
+
+    if ((NULL == p_thread) || (0 != (flags & osFlagsError)))
+    {
+        return osFlagsErrorParameter;
+    }
+
+    _deadline(&deadline, timeout);
+
+    pthread_mutex_lock(&m_lock);
+    for (;;)
+    {
+        uint32_t match = p_thread->flags & flags;
+
+        result = p_thread->flags;
+        if ((0 != (options & osFlagsWaitAll)) ? (match == flags) : (0 != match))
+        {
+            if (0 == (options & osFlagsNoClear))
+            {
+                p_thread->flags &= ~flags;
+            }
+            break;
+        }
+
+        if (0 == timeout)
+        {
+            result = osFlagsErrorResource;
+            break;
+        }
+
+        if (osWaitForever == timeout)
+        {
+            pthread_cond_wait(&m_changed, &m_lock);
+        }
+        else if (ETIMEDOUT == pthread_cond_timedwait(&m_changed, &m_lock, &deadline))
+        {
+            result = osFlagsErrorTimeout;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    return result;
+}
+
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    struct timespec deadline;
+
+    _deadline(&deadline, ticks);
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL))
+    {
+    }
+
+    return osOK;
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * File Name          : cmsis_os.h
+  * Description        : This file replaces the CMSIS-RTOS2 wrapper of FreeRTOS
+  *                      in the host build of the common library.
+  *
+  * The API is the one of cmsis_os2.h, which is included as is.  Only the
+  * functions used by the common library are implemented, on top of POSIX
+  * threads, see cmsis_os.c:
+  *
+  *  - osKernelInitialize(), osKernelStart(), osKernelGetState(),
+  *    osKernelLock(), osKernelUnlock(), osKernelRestoreLock(),
+  *    osKernelGetTickCount() and osKernelGetTickFreq().
+  *
+  *  - osThreadNew(), osThreadGetId(), osThreadExit(), osThreadFlagsSet() and
+  *    osThreadFlagsWait().
+  *
+  *  - osDelay().
+  *
+  * Every thread runs at the same time, the priorities are ignored and
+  * osKernelLock() doesn't stop the other threads.  Code that only works
+  * because of the FreeRTOS scheduling will fail here, which is the point.
+  */
+
+#ifndef __X_HOST_CMSIS_OS_H
+#define __X_HOST_CMSIS_OS_H
+
+#include "cmsis_os2.h"
+
+#endif  // __X_HOST_CMSIS_OS_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * File Name          : log_stdio.c
+  * Description        : This file implements the log backend that writes to
+  *                      the standard output of the host build.
+  *
+  * Every write is a single write() call, so the messages of the log task
+  * and of log_dump() don't interleave within a line.  Nothing is received,
+  * the log level commands can't be used.
+  */
+
+#define _POSIX_C_SOURCE         200809L
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "log_backend.h"
+
+#if LOG_BACKEND_STDIO
+
+void log_backend_init(void)
+{
+}
+
+
+void log_backend_write(const char *str, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(STDOUT_FILENO, str, len);
+
+        if ((written < 0) && (EINTR == errno))
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return;
+        }
+        str += written;
+        len -= written;
+    }
+}
+
+
+char *log_backend_reserve(size_t *p_size, uint32_t *p_state)
+{
+    *p_size = 0;
+    return NULL;
+}
+
+
+void log_backend_commit(size_t length, uint32_t state)
+{
+}
+
+
+size_t log_backend_read(char *buffer, size_t size)
+{
+    return 0;
+}
+
+
+void log_backend_flush(void)
+{
+    // write() doesn't buffer
+}
+
+#endif  // LOG_BACKEND_STDIO
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * File Name          : main.h
+  * Description        : This file replaces the CubeMX main.h in the host
+  *                      build of the common library.
+  *
+  * The debug pins are the ones of stm32cubemx/Core/Inc/main.h.
+  */
+
+#ifndef __X_HOST_MAIN_H
+#define __X_HOST_MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32h7xx_hal.h"
+
+#define DBG3_Pin                GPIO_PIN_5
+#define DBG3_GPIO_Port          GPIOA
+#define DBG4_Pin                GPIO_PIN_6
+#define DBG4_GPIO_Port          GPIOA
+#define DBG1_Pin                GPIO_PIN_8
+#define DBG1_GPIO_Port          GPIOB
+#define DBG2_Pin                GPIO_PIN_9
+#define DBG2_GPIO_Port          GPIOB
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_HOST_MAIN_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32h7xx.h
+  * Description        : This file replaces the CMSIS device header in the
+  *                      host build of the common library.
+  *
+  * Only the core registers and intrinsics used by the common library are
+  * provided:
+  *
+  *  - SystemCoreClock is 1 GHz, so a cycle is a nanosecond.
+  *
+  *  - DWT->CYCCNT reads the monotonic clock in nanoseconds, modulo 2^32.
+  *    The writes of cycles_init() go to a copy that is never read.
+  *
+  *  - __get_IPSR() returns the value set with host_irq_set(), so a thread
+  *    can act as an interrupt handler.  PRIMASK and BASEPRI are always 0.
+  *
+  *  - The SysTick registers stay 0 and the NVIC functions do nothing, they
+  *    are only used by cmsis_os2.c in the simulation.
+  */
+
+#ifndef __X_HOST_STM32H7XX_H
+#define __X_HOST_STM32H7XX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**@brief   The core clock frequency in Hz. */
+extern uint32_t SystemCoreClock;
+
+/**@brief   The part of the DWT registers used by cycles.c. */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+    volatile uint32_t LAR;
+} DWT_Type;
+
+/**@brief   The part of the core debug registers used by cycles.c. */
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+/**@brief   The part of the SysTick registers used by cmsis_os2.c. */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+} SysTick_Type;
+
+typedef int32_t IRQn_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+/**@brief   Get the DWT registers of the thread with CYCCNT up to date. */
+DWT_Type *host_dwt(void);
+
+/**@brief   Get the core debug registers. */
+CoreDebug_Type *host_core_debug(void);
+
+extern SysTick_Type host_systick;
+
+#define DWT                     (host_dwt())
+#define CoreDebug               (host_core_debug())
+#define SysTick                 (&host_systick)
+
+/**@brief   Set the exception number returned by __get_IPSR() in the calling
+ *          thread, 0 for thread mode.
+ */
+void host_irq_set(uint32_t irq);
+
+/**@brief   Get the exception number set with host_irq_set(). */
+uint32_t __get_IPSR(void);
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0;
+}
+
+static inline uint32_t __get_BASEPRI(void)
+{
+    return 0;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+static inline void __enable_irq(void)
+{
+}
+
+static inline void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+}
+
+static inline void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __DSB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_HOST_STM32H7XX_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
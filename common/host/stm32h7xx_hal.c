@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32h7xx_hal.c
+  * Description        : This file implements the core registers and the HAL
+  *                      functions of the host build of the common library.
+  */
+
+#define _POSIX_C_SOURCE         200809L
+
+#include <time.h>
+
+#include "stm32h7xx_hal.h"
+
+uint32_t SystemCoreClock = 1000000000;
+
+GPIO_TypeDef host_gpio[8];
+
+SysTick_Type host_systick;
+
+/**@brief   The DWT registers, per thread since CYCCNT is updated on read. */
+static __thread DWT_Type m_dwt;
+
+/**@brief   The core debug registers. */
+static CoreDebug_Type m_core_debug;
+
+/**@brief   The exception number returned by __get_IPSR(). */
+static __thread uint32_t m_ipsr;
+
+
+DWT_Type *host_dwt(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    m_dwt.CYCCNT = (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+
+    return &m_dwt;
+}
+
+
+CoreDebug_Type *host_core_debug(void)
+{
+    return &m_core_debug;
+}
+
+
+void host_irq_set(uint32_t irq)
+{
+    m_ipsr = irq;
+}
+
+
+uint32_t __get_IPSR(void)
+{
+    return m_ipsr;
+}
+
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    GPIOx->MODER |= GPIO_Init->Pin;
+}
+
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (0 != (GPIOx->ODR & GPIO_Pin)) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (GPIO_PIN_RESET != PinState)
+    {
+        __atomic_fetch_or(&GPIOx->ODR, GPIO_Pin, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_fetch_and(&GPIOx->ODR, ~(uint32_t)GPIO_Pin, __ATOMIC_RELAXED);
+    }
+}
+
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    __atomic_fetch_xor(&GPIOx->ODR, GPIO_Pin, __ATOMIC_RELAXED);
+}
+
+
+uint32_t HAL_GetTick(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+
+void HAL_Delay(uint32_t Delay)
+{
+    struct timespec delay =
+    {
+        .tv_sec = Delay / 1000,
+        .tv_nsec = (Delay % 1000) * 1000000,
+    };
+
+    // Restart with the time left if a signal interrupts the sleep
+    while (0 != nanosleep(&delay, &delay))
+    {
+    }
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
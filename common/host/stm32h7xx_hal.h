@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32h7xx_hal.h
+  * Description        : This file replaces the STM32H7 HAL in the host build
+  *                      of the common library.
+  *
+  * The GPIO functions only update the output data register of the port, so
+  * a test can read back what debug.c wrote.  HAL_GetTick() and HAL_Delay()
+  * use the monotonic clock, HAL_Delay() doesn't yield to the scheduler on
+  * the target either.
+  */
+
+#ifndef __X_HOST_STM32H7XX_HAL_H
+#define __X_HOST_STM32H7XX_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "stm32h7xx.h"
+
+/**@brief   The part of the GPIO registers used by the HAL functions below. */
+typedef struct
+{
+    volatile uint32_t MODER;
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+/**@brief   The GPIO settings of HAL_GPIO_Init(). */
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+/**@brief   The GPIO ports A to H. */
+extern GPIO_TypeDef host_gpio[8];
+
+#define GPIOA                   (&host_gpio[0])
+#define GPIOB                   (&host_gpio[1])
+#define GPIOC                   (&host_gpio[2])
+#define GPIOD                   (&host_gpio[3])
+#define GPIOE                   (&host_gpio[4])
+#define GPIOF                   (&host_gpio[5])
+#define GPIOG                   (&host_gpio[6])
+#define GPIOH                   (&host_gpio[7])
+
+#define GPIO_PIN_0              ((uint16_t)0x0001)
+#define GPIO_PIN_1              ((uint16_t)0x0002)
+#define GPIO_PIN_2              ((uint16_t)0x0004)
+#define GPIO_PIN_3              ((uint16_t)0x0008)
+#define GPIO_PIN_4              ((uint16_t)0x0010)
+#define GPIO_PIN_5              ((uint16_t)0x0020)
+#define GPIO_PIN_6              ((uint16_t)0x0040)
+#define GPIO_PIN_7              ((uint16_t)0x0080)
+#define GPIO_PIN_8              ((uint16_t)0x0100)
+#define GPIO_PIN_9              ((uint16_t)0x0200)
+#define GPIO_PIN_10             ((uint16_t)0x0400)
+#define GPIO_PIN_11             ((uint16_t)0x0800)
+#define GPIO_PIN_12             ((uint16_t)0x1000)
+#define GPIO_PIN_13             ((uint16_t)0x2000)
+#define GPIO_PIN_14             ((uint16_t)0x4000)
+#define GPIO_PIN_15             ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT         0x00000000U
+#define GPIO_MODE_OUTPUT_PP     0x00000001U
+#define GPIO_NOPULL             0x00000000U
+#define GPIO_PULLDOWN           0x00000002U
+#define GPIO_SPEED_FREQ_LOW     0x00000000U
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_HOST_STM32H7XX_HAL_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * File Name          : ut_log_hpp.cpp
+  * Description        : This file implements the C++ part of the runner of
+  *                      the host build of the common library.
+  *
+  * It includes log.hpp, so every LOG_* call below is checked against its
+  * arguments at compile time and its arguments go through logging::pack().
+  * The file is built with LOG_DEFERRED set to 0, linked in the runner, and
+  * to 1, only compiled, so both sets of hooks of log.h are checked.
+  */
+
+#include <cstdint>
+
+#define LOG_MODULE_NAME         ut_hpp
+#define LOG_LEVEL               LOG_LEVEL_DEBUG
+
+#include "log.hpp"
+
+#include "stm32h7xx.h"
+
+/**@brief   An enumeration logged as an integer. */
+enum ut_color
+{
+    UT_RED,
+    UT_GREEN,
+};
+
+/**@brief   A scoped enumeration logged as an integer. */
+enum class ut_state : uint8_t
+{
+    idle,
+    busy,
+};
+
+
+extern "C" void ut_log_hpp(void)
+{
+    int number = -42;
+    long counter = 123456L;
+    unsigned value = 0xBEEFu;
+    const char *name = "hpp";
+    char buffer[] = "buffer";
+    const void *address = &number;
+    int width = 8;
+
+    LOG_INFO("int %d, long %ld, unsigned 0x%08x\n", number, counter, value);
+    LOG_INFO("enum %d, scoped enum %u, char %c\n", UT_GREEN, ut_state::busy, 'x');
+    LOG_INFO("string %s, array %s, pointer %p\n", name, buffer, address);
+    LOG_INFO("width %*d|, precision %.*s|, 100%%\n", width, number, 2, name);
+    LOG_DEBUG("No arguments\n");
+
+    LOG_RAW_INFO("Raw int %d, long %ld, string %s\n", number, counter, name);
+
+    // As if from an interrupt handler, the arguments are stored as words
+    host_irq_set(16);
+    LOG_ISR_INFO("ISR int %d, long %lu, enum %d\n", number, counter, UT_RED);
+    LOG_ISR_INFO("ISR string %s, pointer %p, 100%%\n", name, address);
+    LOG_ISR_INFO("ISR width %*x|\n", width, value);
+    host_irq_set(0);
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
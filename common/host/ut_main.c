@@ -0,0 +1,784 @@
+/**
+  ******************************************************************************
+  * File Name          : ut_main.c
+  * Description        : This file implements the runner of the host build of
+  *                      the common library.
+  *
+  * main() starts the modules the same way the application does, which runs
+  * their UNIT_TEST code, then a test task checks what can be checked without
+  * reading the log output back.  The log output goes to stdout for a human,
+  * the failed checks go to stderr and set the exit status.  With
+  * LOG_BENCHMARK it also waits for the rows of common/log_bench.c.
+  */
+
+#define _POSIX_C_SOURCE         200809L
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LOG_MODULE_NAME         ut
+#define LOG_LEVEL               LOG_LEVEL_DEBUG
+
+#include "log.h"
+#include "log_bench.h"
+#include "log_printf.h"
+#include "log_ring.h"
+#include "debug.h"
+#include "utils.h"
+
+#include "cmsis_os.h"
+#include "main.h"
+
+/**@brief   The number of threads logging at the same time.
+ */
+#define UT_THREADS              4
+
+/**@brief   The number of messages logged by each thread.
+ */
+#define UT_MESSAGES             50
+
+/**@brief   The number of threads adding records to the ring under test.
+ */
+#define UT_RING_PRODUCERS       6
+
+/**@brief   The number of records added by each of them.
+ */
+#define UT_RING_RECORDS         100000
+
+/**@brief   The size of the ring under test, small so that it's often full
+ *          and wraps around.
+ */
+#define UT_RING_SIZE            1024
+
+/**@brief   The most payload words of a record of the ring under test.
+ */
+#define UT_RING_MAX_WORDS       13
+
+/**@brief   Check a condition, report it on stderr if it fails.
+ */
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                        \
+                    __FILE__, __LINE__, #condition);                            \
+            m_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+/**@brief   The type of the argument of a printf case.
+ */
+typedef enum
+{
+    UT_ARG_INT,
+    UT_ARG_UINT,
+    UT_ARG_LONG,
+    UT_ARG_ULONG,
+    UT_ARG_LLONG,
+    UT_ARG_ULLONG,
+    UT_ARG_SIZE,
+    UT_ARG_INTMAX,
+    UT_ARG_PTRDIFF,
+    UT_ARG_STRING,
+    UT_ARG_POINTER,
+} ut_arg_t;
+
+/**@brief   A case of the comparison of log_snprintf() with snprintf().
+ */
+typedef struct
+{
+    const char *fmt;            /**< The format string. */
+    ut_arg_t type;              /**< The type of the argument. */
+    int star;                   /**< Passed first when fmt has a '*'. */
+    long long number;           /**< The argument if it's an integer. */
+    const char *string;         /**< The argument if it's a string. */
+} ut_printf_case_t;
+
+/**@brief   The cases of the printf comparison.  Every case is also formatted
+ *          into buffers that are too small, see _test_printf().
+ */
+static const ut_printf_case_t m_printf_cases[] =
+{
+    // Flags, width and precision
+    { "%d",             UT_ARG_INT,     0,  0 },
+    { "%d",             UT_ARG_INT,     0,  -2147483647 - 1 },
+    { "%i|%%",          UT_ARG_INT,     0,  42 },
+    { "%5d|",           UT_ARG_INT,     0,  -42 },
+    { "%-5d|",          UT_ARG_INT,     0,  -42 },
+    { "%05d",           UT_ARG_INT,     0,  -42 },
+    { "%+d % d",        UT_ARG_INT,     0,  42 },
+    { "% 05d",          UT_ARG_INT,     0,  42 },
+    { "%.3d",           UT_ARG_INT,     0,  7 },
+    { "%8.3d|",         UT_ARG_INT,     0,  -7 },
+    { "%-+8.3d|",       UT_ARG_INT,     0,  7 },
+    { "%08.3d",         UT_ARG_INT,     0,  7 },
+    { "%.0d|",          UT_ARG_INT,     0,  0 },
+    { "%*d|",           UT_ARG_INT,     6,  123 },
+    { "%*d|",           UT_ARG_INT,     -6, 123 },
+    { "%.*d|",          UT_ARG_INT,     4,  5 },
+    { "%.*d|",          UT_ARG_INT,     -1, 5 },
+    { "%u",             UT_ARG_UINT,    0,  4294967295LL },
+    { "%o %#o",         UT_ARG_UINT,    0,  8 },
+    { "%#o",            UT_ARG_UINT,    0,  0 },
+    { "%x %X",          UT_ARG_UINT,    0,  0xBEEF },
+    { "%#x %#X",        UT_ARG_UINT,    0,  0xBEEF },
+    { "%#x",            UT_ARG_UINT,    0,  0 },
+    { "%#010x",         UT_ARG_UINT,    0,  0x1234 },
+    { "%-#10x|",        UT_ARG_UINT,    0,  0x1234 },
+    { "%#.6x",          UT_ARG_UINT,    0,  0x1234 },
+    { "%08X",           UT_ARG_UINT,    0,  0xDEADBEEF },
+
+    // Lengths
+    { "%hhd %hhu",      UT_ARG_INT,     0,  0x1FF },
+    { "%hhx",           UT_ARG_INT,     0,  -1 },
+    { "%hd %hu",        UT_ARG_INT,     0,  0x18000 },
+    { "%hx",            UT_ARG_INT,     0,  -1 },
+    { "%ld",            UT_ARG_LONG,    0,  -1234567890L },
+    { "%lu %lx",        UT_ARG_ULONG,   0,  0xFFFFFFFFUL },
+    { "%lld",           UT_ARG_LLONG,   0,  -9223372036854775807LL - 1 },
+    { "%llu",           UT_ARG_ULLONG,  0,  -1 },
+    { "%#llx",          UT_ARG_ULLONG,  0,  0x123456789ABCDEFLL },
+    { "%020lld",        UT_ARG_LLONG,   0,  -1234567890123LL },
+    { "%zu %zx",        UT_ARG_SIZE,    0,  65536 },
+    { "%zd",            UT_ARG_SIZE,    0,  -5 },
+    { "%jd",            UT_ARG_INTMAX,  0,  -9000000000LL },
+    { "%ju",            UT_ARG_INTMAX,  0,  9000000000LL },
+    { "%td",            UT_ARG_PTRDIFF, 0,  -77 },
+    { "%tx",            UT_ARG_PTRDIFF, 0,  0x77 },
+
+    // Characters, strings and pointers
+    { "%c",             UT_ARG_INT,     0,  'A' },
+    { "%3c|%-3c|",      UT_ARG_INT,     0,  'z' },
+    { "%s",             UT_ARG_STRING,  0,  0,  "" },
+    { "%s",             UT_ARG_STRING,  0,  0,  "hello" },
+    { "%8s|",           UT_ARG_STRING,  0,  0,  "hello" },
+    { "%-8s|",          UT_ARG_STRING,  0,  0,  "hello" },
+    { "%.3s|",          UT_ARG_STRING,  0,  0,  "hello" },
+    { "%08s|",          UT_ARG_STRING,  0,  0,  "hello" },
+    { "%*s|",           UT_ARG_STRING,  7,  0,  "hello" },
+    { "%-*s|",          UT_ARG_STRING,  7,  0,  "hello" },
+    { "%.*s|",          UT_ARG_STRING,  2,  0,  "hello" },
+    { "%s: %s: ",       UT_ARG_STRING,  0,  0,  "Info" },
+    { "%p",             UT_ARG_POINTER, 0,  0x20001234 },
+    { "%20p|",          UT_ARG_POINTER, 0,  0x20001234 },
+    { "%-20p|",         UT_ARG_POINTER, 0,  0x20001234 },
+    { "100%% %c%%",     UT_ARG_INT,     0,  'x' },
+};
+
+/**@brief   Log through log.hpp with every kind of argument, see
+ *          ut_log_hpp.cpp.
+ */
+void ut_log_hpp(void);
+
+/**@brief   Used by MODULE_INITIALIZED(). */
+static bool m_initialized = false;
+
+/**@brief   The number of failed checks. */
+static int m_failures = 0;
+
+/**@brief   The attributes of the test task. */
+static const osThreadAttr_t m_test_task_attributes =
+{
+    .name = "ut",
+    .priority = (osPriority_t)osPriorityNormal,
+    .stack_size = 512 * 4,
+};
+
+/**@brief   The attributes of the logging threads. */
+static const osThreadAttr_t m_logger_task_attributes =
+{
+    .name = "ut_logger",
+    .priority = (osPriority_t)osPriorityNormal,
+    .stack_size = 512 * 4,
+};
+
+/**@brief   The number of logging threads that have finished. */
+static uint32_t m_loggers_done = 0;
+
+/**@brief   A record of the ring under test.
+ *
+ * The length of the payload changes with the sequence number, so records of
+ * every size wrap around the end of the buffer.
+ */
+typedef struct
+{
+    uint32_t producer;          /**< The thread that added the record. */
+    uint32_t sequence;          /**< Counts the records of the thread. */
+    uint32_t words;             /**< The number of words in payload. */
+    uint32_t checksum;          /**< Of the fields above and the payload. */
+    uint32_t payload[UT_RING_MAX_WORDS];
+} ut_ring_record_t;
+
+/**@brief   The ring under test and its storage. */
+static log_ring_t m_ring;
+static uint32_t m_ring_buffer[UT_RING_SIZE / sizeof(uint32_t)];
+
+/**@brief   The number of producers that have finished. */
+static uint32_t m_producers_done = 0;
+
+
+/**@brief   Internal function used to test MODULE_INITIALIZED().
+ *
+ * @return  1 if the module is initialized, 0 if not.
+ */
+static int _initialized(void)
+{
+    MODULE_INITIALIZED(0);
+
+    return 1;
+}
+
+
+/**@brief   Internal function used to format a printf case.
+ *
+ * @param[in]   print   snprintf() or log_snprintf().
+ * @param[out]  buffer  The buffer to format into, may be NULL if size is 0.
+ * @param[in]   size    The size of the buffer in bytes.
+ * @param[in]   p_case  The case to format.
+ *
+ * @return  The value returned by print.
+ */
+static int _format_case(
+    int (*print)(char *buffer, size_t size, const char *fmt, ...),
+    char *buffer,
+    size_t size,
+    const ut_printf_case_t *p_case
+)
+{
+    const char *fmt = p_case->fmt;
+    long long number = p_case->number;
+    bool star = (NULL != strchr(fmt, '*'));
+
+    // The argument is passed twice for the cases with two conversions
+#define UT_PRINT(VALUE)                                                         \
+    (star ? print(buffer, size, fmt, p_case->star, (VALUE)) :                   \
+            print(buffer, size, fmt, (VALUE), (VALUE)))
+
+    switch (p_case->type)
+    {
+        case UT_ARG_INT:        return UT_PRINT((int)number);
+        case UT_ARG_UINT:       return UT_PRINT((unsigned)number);
+        case UT_ARG_LONG:       return UT_PRINT((long)number);
+        case UT_ARG_ULONG:      return UT_PRINT((unsigned long)number);
+        case UT_ARG_LLONG:      return UT_PRINT(number);
+        case UT_ARG_ULLONG:     return UT_PRINT((unsigned long long)number);
+        case UT_ARG_SIZE:       return UT_PRINT((size_t)number);
+        case UT_ARG_INTMAX:     return UT_PRINT((intmax_t)number);
+        case UT_ARG_PTRDIFF:    return UT_PRINT((ptrdiff_t)number);
+        case UT_ARG_STRING:     return UT_PRINT(p_case->string);
+        case UT_ARG_POINTER:    return UT_PRINT((void *)(uintptr_t)number);
+    }
+#undef UT_PRINT
+
+    return -1;
+}
+
+
+/**@brief   Compare log_snprintf() with the snprintf() of the C library.
+ *
+ * Every case is formatted into a large buffer, into buffers that are an
+ * exact fit, one byte short and one byte long, and with a size of 0 and a
+ * NULL buffer.  The output and the return value must be the same.
+ */
+static void _test_printf(void)
+{
+    for (size_t index = 0; index < sizeof(m_printf_cases) / sizeof(m_printf_cases[0]); index++)
+    {
+        const ut_printf_case_t *p_case = &m_printf_cases[index];
+        char expected[128];
+        int length = _format_case(snprintf, expected, sizeof(expected), p_case);
+        size_t sizes[] = { sizeof(expected), length + 1, length, 1, length + 2 };
+
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            char libc[128];
+            char ours[128];
+
+            memset(libc, '#', sizeof(libc));
+            memset(ours, '#', sizeof(ours));
+
+            int libc_length = _format_case(snprintf, libc, sizes[i], p_case);
+            int our_length = _format_case(log_snprintf, ours, sizes[i], p_case);
+
+            if ((libc_length != our_length) || (0 != memcmp(libc, ours, sizeof(libc))))
+            {
+                fprintf(stderr, "printf case \"%s\" size %zu: \"%.*s\" (%d), "
+                        "expected \"%.*s\" (%d)\n", p_case->fmt, sizes[i],
+                        (int)sizes[i], ours, our_length,
+                        (int)sizes[i], libc, libc_length);
+                m_failures++;
+            }
+        }
+
+        CHECK(length == _format_case(log_snprintf, NULL, 0, p_case));
+    }
+}
+
+
+/**@brief   Internal function used to capture the log output.
+ *
+ * @param[out]  p_saved     Set to the descriptor of the real stdout.
+ *
+ * @return  The non-blocking read end of the pipe stdout now writes to, -1 on
+ *          failure.
+ */
+static int _capture_start(int *p_saved)
+{
+    int fds[2];
+
+    *p_saved = dup(STDOUT_FILENO);
+    if ((*p_saved < 0) || (0 != pipe(fds)))
+    {
+        return -1;
+    }
+
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    dup2(fds[1], STDOUT_FILENO);
+    close(fds[1]);
+
+    return fds[0];
+}
+
+
+/**@brief   Internal function used to wait for a line of the captured log
+ *          output.
+ *
+ * @param[in]   fd      The descriptor returned by _capture_start().
+ * @param[in]   start   The line must start with these characters.
+ * @param[out]  line    Set to the line, with its newline.
+ * @param[in]   size    The size of line in bytes.
+ *
+ * @return  The length of the line, 0 if it wasn't found within a second.
+ */
+static size_t _capture_line(int fd, const char *start, char *line, size_t size)
+{
+    static char captured[8192];
+    size_t length = 0;
+
+    for (int wait = 0; wait < 100; wait++)
+    {
+        ssize_t count = read(fd, captured + length, sizeof(captured) - length);
+
+        if (count > 0)
+        {
+            length += count;
+        }
+
+        // Search with memchr(), the line may hold a NULL character
+        char *p = captured;
+        char *end;
+
+        while (NULL != (end = memchr(p, '\n', captured + length - p)))
+        {
+            if ((0 == strncmp(p, start, strlen(start))) && ((size_t)(end - p) < size))
+            {
+                memcpy(line, p, end - p + 1);
+                return end - p + 1;
+            }
+            p = end + 1;
+        }
+
+        osDelay(10);
+    }
+
+    return 0;
+}
+
+
+/**@brief   Internal function used to stop capturing the log output.
+ *
+ * @param[in]   fd      The descriptor returned by _capture_start().
+ * @param[in]   saved   The descriptor of the real stdout.
+ */
+static void _capture_stop(int fd, int saved)
+{
+    if (saved >= 0)
+    {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+
+/**@brief   Check that a message that doesn't fit after a long prefix is
+ *          truncated and not padded with whatever is on the stack.
+ *
+ * The module and the path are passed to log_entry() directly so the prefix
+ * is long whether LOG_FILE_LINE is set or not.
+ */
+static void _test_long_line(void)
+{
+    // Too long for the message without LOG_FILE_LINE, short enough to leave
+    // room for some of it with LOG_FILE_LINE and LOG_TIMESTAMP
+    static const char module[] =
+        "ut_module_with_a_name_as_long_as_the_absolute_path_of_a_file_of_the_build_dir";
+    static const char file[] =
+        "/home/builder/projects/H723_basic/common/host/some/deeper/directory/ut_main.c";
+    char message[120];
+    char line[512];
+    char start[sizeof(module) + 16];
+    int saved;
+
+    // 119 characters with the newline
+    for (size_t i = 0; i < sizeof(message) - 2; i++)
+    {
+        message[i] = 'a' + (i % 26);
+    }
+    message[sizeof(message) - 2] = '\n';
+    message[sizeof(message) - 1] = '\0';
+
+    snprintf(start, sizeof(start), "Info: %s: ", module);
+
+    // Let the log task write the earlier messages to the real stdout
+    osDelay(100);
+
+    int fd = _capture_start(&saved);
+    CHECK(fd >= 0);
+    if (fd < 0)
+    {
+        _capture_stop(fd, saved);
+        return;
+    }
+
+    log_entry(LOG_LEVEL_INFO, module, false, file, __LINE__, "%s", message);
+    size_t length = _capture_line(fd, start, line, sizeof(line));
+    _capture_stop(fd, saved);
+
+    CHECK(0 != length);
+    if (0 == length)
+    {
+        return;
+    }
+
+    // The message follows the last space of the prefix
+    size_t body = 0;
+    size_t unprintable = 0;
+
+    for (size_t i = 0; i < length - 1; i++)
+    {
+        if (!isprint((unsigned char)line[i]))
+        {
+            unprintable++;
+        }
+        else if (' ' == line[i])
+        {
+            body = i + 1;
+        }
+    }
+
+    CHECK(0 == unprintable);
+    CHECK(body < length - 1);
+
+    // Whatever is left of the message is its start
+    CHECK(0 == memcmp(line + body, message, length - 1 - body));
+}
+
+
+/**@brief   Check the debug pins against the GPIO output registers.
+ */
+static void _test_debug(void)
+{
+    debug_set(DEBUG_PIN_1);
+    CHECK(GPIO_PIN_SET == HAL_GPIO_ReadPin(DBG1_GPIO_Port, DBG1_Pin));
+    CHECK(GPIO_PIN_RESET == HAL_GPIO_ReadPin(DBG2_GPIO_Port, DBG2_Pin));
+
+    debug_clear(DEBUG_PIN_1);
+    CHECK(GPIO_PIN_RESET == HAL_GPIO_ReadPin(DBG1_GPIO_Port, DBG1_Pin));
+
+    debug_toggle(DEBUG_PIN_3);
+    CHECK(GPIO_PIN_SET == HAL_GPIO_ReadPin(DBG3_GPIO_Port, DBG3_Pin));
+    debug_toggle(DEBUG_PIN_3);
+    CHECK(GPIO_PIN_RESET == HAL_GPIO_ReadPin(DBG3_GPIO_Port, DBG3_Pin));
+
+    debug_pulse(DEBUG_PIN_4, 10, 3);
+    CHECK(GPIO_PIN_RESET == HAL_GPIO_ReadPin(DBG4_GPIO_Port, DBG4_Pin));
+}
+
+
+/**@brief   Check the module levels and the level commands.
+ */
+static void _test_levels(void)
+{
+    CHECK(LOG_LEVEL_DEBUG == log_level_get("ut"));
+
+    CHECK(log_level_set("ut", LOG_LEVEL_ERROR));
+    CHECK(LOG_LEVEL_ERROR == log_level_get("ut"));
+    LOG_INFO("This message must not appear\n");
+
+    CHECK(log_level_command("log ut debug"));
+    CHECK(LOG_LEVEL_DEBUG == log_level_get("ut"));
+
+    CHECK(!log_level_set("no_such_module", LOG_LEVEL_DEBUG));
+    CHECK(!log_level_command("log ut loud"));
+}
+
+
+/**@brief   Log messages at the same time as the other logging threads.
+ *
+ * @param[in]   argument    The number of the thread.
+ */
+static void _logger_task(void *argument)
+{
+    uint32_t id = (uint32_t)(uintptr_t)argument;
+
+    for (uint32_t i = 0; i < UT_MESSAGES; i++)
+    {
+        if (0 == (i % 10))
+        {
+            // Every tenth message is logged as if from an interrupt handler
+            host_irq_set(16 + id);
+            LOG_ISR_INFO("Thread %lu interrupt message %lu\n",
+                         (unsigned long)id, (unsigned long)i);
+            host_irq_set(0);
+        }
+        else
+        {
+            LOG_INFO("Thread %lu message %lu\n", (unsigned long)id, (unsigned long)i);
+        }
+    }
+
+    __atomic_fetch_add(&m_loggers_done, 1, __ATOMIC_RELEASE);
+    osThreadExit();
+}
+
+
+/**@brief   Log from several threads and check nothing was dropped.
+ *
+ * The producers block while the ring is full, the interrupt messages don't.
+ */
+static void _test_threads(void)
+{
+    uint8_t data[40];
+    log_stats_t stats;
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+    LOG_HEX_INFO("ut data", data, sizeof(data), 16);
+
+    // The threads log faster than the log task writes to stdout
+    log_overflow_set(LOG_OVERFLOW_BLOCK, 1000);
+
+    for (uint32_t id = 0; id < UT_THREADS; id++)
+    {
+        CHECK(NULL != osThreadNew(_logger_task, (void *)(uintptr_t)id,
+                                  &m_logger_task_attributes));
+    }
+
+    while (UT_THREADS != __atomic_load_n(&m_loggers_done, __ATOMIC_ACQUIRE))
+    {
+        osDelay(10);
+    }
+
+    log_overflow_set(LOG_OVERFLOW_POLICY, LOG_OVERFLOW_TIMEOUT_MS);
+
+    log_stats_get(&stats);
+    CHECK(0 == stats.dropped_newest);
+    CHECK(0 == stats.dropped_oldest);
+    CHECK(0 == stats.timed_out);
+}
+
+
+/**@brief   Internal function used to get the checksum of a record.
+ *
+ * @param[in]   p_record    The record, with words set.
+ *
+ * @return  The checksum of the record.
+ */
+static uint32_t _ring_checksum(const ut_ring_record_t *p_record)
+{
+    uint32_t sum = p_record->producer ^ (p_record->sequence << 8) ^ (p_record->words << 24);
+
+    for (uint32_t i = 0; i < p_record->words; i++)
+    {
+        sum = ((sum << 5) | (sum >> 27)) ^ p_record->payload[i];
+    }
+
+    return sum;
+}
+
+
+/**@brief   Add sequence numbered records to the ring under test.
+ *
+ * @param[in]   argument    The number of the thread.
+ */
+static void _ring_producer_task(void *argument)
+{
+    uint32_t id = (uint32_t)(uintptr_t)argument;
+
+    for (uint32_t sequence = 0; sequence < UT_RING_RECORDS; sequence++)
+    {
+        uint32_t words = (sequence + id) % (UT_RING_MAX_WORDS + 1);
+        size_t length = offsetof(ut_ring_record_t, payload) + words * sizeof(uint32_t);
+        ut_ring_record_t *p_record;
+
+        // The consumer is slower than the producers, wait for room
+        while (NULL == (p_record = log_ring_reserve(&m_ring, length)))
+        {
+            sched_yield();
+        }
+
+        // Let the others reserve and commit behind an uncommitted record,
+        // which also happens on a single core
+        if (0 == (sequence % 7))
+        {
+            sched_yield();
+        }
+
+        p_record->producer = id;
+        p_record->sequence = sequence;
+        p_record->words = words;
+        for (uint32_t i = 0; i < words; i++)
+        {
+            p_record->payload[i] = (sequence * 2654435761u) ^ (id << 24) ^ i;
+        }
+        p_record->checksum = _ring_checksum(p_record);
+
+        log_ring_commit(&m_ring, p_record);
+    }
+
+    __atomic_fetch_add(&m_producers_done, 1, __ATOMIC_RELEASE);
+    osThreadExit();
+}
+
+
+/**@brief   Read the records added to a ring by several threads at once and
+ *          check that none is lost, out of order or torn.
+ */
+static void _test_ring(void)
+{
+    uint32_t expected[UT_RING_PRODUCERS] = { 0 };
+    uint32_t records = 0;
+    uint32_t errors = 0;
+
+    log_ring_init(&m_ring, m_ring_buffer, sizeof(m_ring_buffer));
+
+    for (uint32_t id = 0; id < UT_RING_PRODUCERS; id++)
+    {
+        CHECK(NULL != osThreadNew(_ring_producer_task, (void *)(uintptr_t)id,
+                                  &m_logger_task_attributes));
+    }
+
+    CHECK(log_ring_lock(&m_ring));
+
+    for (;;)
+    {
+        size_t length;
+        const ut_ring_record_t *p_record = log_ring_peek(&m_ring, &length);
+
+        if (NULL == p_record)
+        {
+            // Read the counter first, a producer finishes after its last
+            // commit
+            if (UT_RING_PRODUCERS == __atomic_load_n(&m_producers_done, __ATOMIC_ACQUIRE) &&
+                !log_ring_readable(&m_ring))
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        // Report the first few errors only, each one tends to repeat
+        bool valid = (p_record->producer < UT_RING_PRODUCERS) &&
+                     (p_record->words <= UT_RING_MAX_WORDS) &&
+                     (length >= offsetof(ut_ring_record_t, payload) +
+                                p_record->words * sizeof(uint32_t)) &&
+                     (p_record->checksum == _ring_checksum(p_record)) &&
+                     (p_record->sequence == expected[p_record->producer]);
+        if (!valid && (errors++ < 10))
+        {
+            CHECK(valid);
+            fprintf(stderr, "record %lu: producer %lu sequence %lu words %lu\n",
+                    (unsigned long)records, (unsigned long)p_record->producer,
+                    (unsigned long)p_record->sequence, (unsigned long)p_record->words);
+        }
+        if (p_record->producer < UT_RING_PRODUCERS)
+        {
+            expected[p_record->producer] = p_record->sequence + 1;
+        }
+
+        records++;
+        log_ring_release(&m_ring);
+    }
+
+    log_ring_unlock(&m_ring);
+
+    CHECK(0 == errors);
+    CHECK((UT_RING_PRODUCERS * UT_RING_RECORDS) == records);
+    for (uint32_t id = 0; id < UT_RING_PRODUCERS; id++)
+    {
+        CHECK(UT_RING_RECORDS == expected[id]);
+    }
+}
+
+
+/**@brief   Run the checks and end the process.
+ *
+ * @param[in]   argument    Not used.
+ */
+static void _test_task(void *argument)
+{
+    CHECK(1 == _initialized());
+    VALIDATE(0, 0);
+
+    _test_debug();
+    _test_levels();
+    _test_printf();
+    ut_log_hpp();
+    _test_long_line();
+    _test_ring();
+    _test_threads();
+
+#if LOG_BENCHMARK
+    // log_task_init() started the benchmarks, wait for their rows
+    while (!log_bench_done())
+    {
+        osDelay(100);
+    }
+#endif
+
+    // Give the log task time to write everything
+    osDelay(100);
+
+    fprintf(stderr, "%d check(s) failed\n", m_failures);
+    exit((0 == m_failures) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+int main(void)
+{
+    osKernelInitialize();
+
+    log_task_init();
+    debug_init();
+
+    CHECK(0 == _initialized());
+    m_initialized = true;
+
+    if (NULL == osThreadNew(_test_task, NULL, &m_test_task_attributes))
+    {
+        fprintf(stderr, "Can't create the test task\n");
+        return EXIT_FAILURE;
+    }
+
+    osKernelStart();
+
+    return EXIT_FAILURE;
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
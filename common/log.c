@@ -3,9 +3,10 @@
   * File Name          : log.c
   * Description        : This file implements an API for a simple logging
   *                      interface using the UART or RTT.
+  *
+  * The output device is selected in log_backend.h.
   */
 
-#include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -13,33 +14,52 @@
 #define LOG_LEVEL               LOG_LEVEL_INFO
 
 #include "log.h"
+#include "log_ring.h"
+#include "cycles.h"
 
-#include "debug.h"
-
-/**@brief   Set to 1 to use the SEGGER RTT output channel for log messages.
- *          Set to 0 to use ST-LINK UART.
- */
-#define USE_RTT                 1
+#include "log_backend.h"
+#include "log_bench.h"
+#include "log_persist.h"
+#include "log_printf.h"
 
 #include "cmsis_os.h"
+#include "main.h"
 
-#if USE_RTT
-    #define LOG_BACKEND_RTT     1
-#else
-    #define LOG_BACKEND_UART    1
-#endif
-
-#if LOG_BACKEND_RTT
-    #include "SEGGER_RTT.h"
-
-    /**@brief   The RTT buffer ID used to write log messages to.
-     */
-    #define RTT_TERMINAL_ID     0
-#endif
-
-#if LOG_BACKEND_UART
-    #include "usart.h"
-#endif
+#if LOG_DICTIONARY
+/**@brief   Frame types written to the output device in dictionary mode.
+ *
+ * Every frame starts with a LOG_FRAME_HEADER byte header: the frame type, an
+ * info byte holding the log level in the lower nibble and LOG_FRAME_RAW, and
+ * the number of payload bytes that follow.  The payload starts with the
+ * module string ID, 0 if there is no module.  Multi-byte values are little
+ * endian.
+ *
+ * String IDs are the addresses of the strings in the .log_str section of the
+ * ELF file, which isn't loaded on the target.  tools/log_decoder.py uses the
+ * ELF file to turn the frames back into text.
+ */
+#define LOG_FRAME_FORMAT        'F'     /**< Format string ID, argument words. */
+#define LOG_FRAME_TEXT          'T'     /**< Text formatted on the target. */
+#define LOG_FRAME_HEX           'H'     /**< Part of a hex dump. */
+
+#define LOG_FRAME_RAW           0x10    /**< Info bit set for raw messages. */
+#define LOG_FRAME_NO_LEVEL      0x0F    /**< Info level of internal messages. */
+#define LOG_FRAME_TIMESTAMP     0x20    /**< Info bit set if the payload has
+                                          *  the seconds and microseconds
+                                          *  after the module ID. */
+#define LOG_FRAME_FILE_LINE     0x40    /**< Info bit set if the payload has
+                                          *  the file string ID and line
+                                          *  after the timestamp. */
+
+#define LOG_FRAME_HEADER        3
+#define LOG_FRAME_MAX_PAYLOAD   255
+
+/**@brief   Bytes before the description of a LOG_FRAME_HEX payload, after the
+ *          timestamp and file and line words: the size of the area, the
+ *          offset of the first byte, the stride and the description length.
+ */
+#define LOG_FRAME_HEX_HEADER    10
+#endif  // LOG_DICTIONARY
 
 
 /**@brief   Set to 1 to enable some basic testing of the log interface.
@@ -49,7 +69,6 @@
  */
 #define UNIT_TEST               0
 
-#ifndef BUILD_UT
 /**@brief   Handle for the log task. */
 osThreadId_t m_log_task_handle;
 
@@ -61,16 +80,6 @@ const osThreadAttr_t m_log_task_attributes =
     .stack_size = 512 * 4,
 };
 
-/**@brief   Handle for the log queue used to store messages. */
-osMessageQueueId_t m_log_queue_handle;
-
-/**@brief   The attributes for the log queue. */
-const osMessageQueueAttr_t m_log_queue_attributes =
-{
-    .name = "log",
-};
-#endif
-
 /**@brief   An array of names for the log levels.
  *
  * This must match the order of the values of log_level_t enumeration.
@@ -97,362 +106,1857 @@ static const char *m_level_str[] =
  */
 #define MAX_LOG_ENTRY           120
 
-/**@brief   The maximum number of log entries that can be stored.
+/**@brief   The maximum number of bytes of a formatted log line, the message
+ *          plus the level, module, timestamp and file prefix.
+ */
+#define MAX_LOG_LINE            (MAX_LOG_ENTRY + 80)
+
+/**@brief   The size of the ring used to store log records, in bytes.
+ *
+ * This must be a power of two.  A record takes sizeof(log_record_t) plus the
+ * text or argument words, plus 4 bytes of ring overhead, rounded up to a
+ * multiple of 4 bytes.
+ */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE           4096
+#endif
+
+/**@brief   The size of the ring used to store log records from interrupts,
+ *          in bytes.  This must be a power of two.
+ */
+#ifndef LOG_ISR_RING_SIZE
+#define LOG_ISR_RING_SIZE       1024
+#endif
+
+// The ring masks the positions with size - 1, and the size of a padding
+// record, up to the size of the ring, must fit in its header
+_Static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0,
+               "LOG_RING_SIZE must be a power of two");
+_Static_assert(LOG_RING_SIZE <= 0x10000, "LOG_RING_SIZE must be at most 64 KiB");
+_Static_assert((LOG_ISR_RING_SIZE & (LOG_ISR_RING_SIZE - 1)) == 0,
+               "LOG_ISR_RING_SIZE must be a power of two");
+_Static_assert(LOG_ISR_RING_SIZE <= 0x10000, "LOG_ISR_RING_SIZE must be at most 64 KiB");
+
+/**@brief   The thread flag used to wake the log task when a record is added.
+ */
+#define LOG_TASK_FLAG_RECORD    0x0001
+
+/**@brief   How often the log task checks the interrupt ring, in ticks.
+ *
+ * Interrupts don't wake the log task so that they don't need to call the
+ * RTOS.
+ */
+#define LOG_ISR_POLL_TICKS      10
+
+/**@brief   Set to 1 to replace a message that is the same as the one before
+ *          it with a "Last message repeated" count.
+ *
+ * Only messages that aren't raw are compared.  The count is written when a
+ * different message is logged, or every LOG_REPORT_PERIOD_MS.
+ */
+#ifndef LOG_COLLAPSE_REPEATS
+#define LOG_COLLAPSE_REPEATS    1
+#endif
+
+/**@brief   How long _output_block() waits for room in the output buffer
+ *          before it drops the rest of the block, in ticks.
+ */
+#define LOG_BLOCK_TIMEOUT_TICKS 100
+
+/**@brief   How often the log task reports the dropped, rate limited and
+ *          repeated messages, in milliseconds.
  */
-#define LOG_QUEUE_EVENTS        48
+#define LOG_REPORT_PERIOD_MS    1000
+
+/**@brief   The bits of a token bucket holding the number of messages.
+ */
+#define LOG_RATE_TOKENS_SHIFT   24
+
+/**@brief   The bits of a token bucket holding the time it was last filled, in
+ *          milliseconds.
+ */
+#define LOG_RATE_TIME_MASK      0x00FFFFFF
+
+/**@brief   The longest command line that can be received from the host, in
+ *          bytes.  Longer lines are ignored.
+ */
+#define LOG_COMMAND_SIZE        64
 
 /**@brief   The largest area the module will do a complete hex dump on, in
  *          bytes.
  */
-#define MAX_HEX_BYTES           64
+#define MAX_HEX_BYTES           256
 
 /**@brief   If the hex dump area is larger than MAX_HEX_BYTES, this is the
  *          number of bytes that will be printed from the start of the area.
  */
-#define START_HEX_BYTES         32
+#define START_HEX_BYTES         128
 
 /**@brief   If the hex dump area is larger than MAX_HEX_BYTES, this is the
  *          number of bytes that will be printed from the end of the area.
  */
-#define END_HEX_BYTES           32
+#define END_HEX_BYTES           128
+
+/**@brief   The most bytes printed on one line of a hex dump.
+ *
+ * A byte takes 3 characters and every group of 4 bytes one more, the line
+ * must fit in MAX_LOG_ENTRY.
+ */
+#define MAX_HEX_STRIDE          32
+
+/**@brief   The number of bytes printed on one line of a hex dump if the
+ *          stride is 0.
+ */
+#define DEFAULT_HEX_STRIDE      16
+
+/**@brief   Flags of a log record.
+ */
+#define LOG_RECORD_RAW          0x01    /**< A raw message. */
+#define LOG_RECORD_HEX          0x02    /**< A log_hex_t hex dump. */
 
-/**@brief   A structure that will hold a single log entry.
+/**@brief   The header of a log record stored in the ring.
+ *
+ * A record either holds a format string and its raw arguments, or, if fmt is
+ * NULL, the text that was already formatted by log_entry(), or a hex dump if
+ * LOG_RECORD_HEX is set.  Only the arguments, the text or the bytes are
+ * stored, so short messages take less space in the ring.
  */
 typedef struct
 {
-    log_level_t level;              /**< The log level of the message. */
+    uint8_t level;                  /**< The log level of the message. */
+    uint8_t flags;                  /**< LOG_RECORD_* flags. */
+    uint16_t length;                /**< Number of args, or bytes of data. */
     const char *module;             /**< The module that created the message. */
-    bool raw;                       /**< True if a raw message, false otherwise. */
-    char buffer[MAX_LOG_ENTRY];     /**< Buffer containing the message. */
-} log_entry_t;
+    const char *fmt;                /**< Format string, NULL for text. */
+#if LOG_FILE_LINE
+    const char *file;               /**< The file, NULL if unknown. */
+    uint32_t line;                  /**< The line of the file. */
+#endif
+} log_record_t;
+
+/**@brief   The data of a hex dump record.
+ *
+ * The header is followed by the description, which isn't NULL terminated,
+ * and the bytes of the area.  If the area is larger than MAX_HEX_BYTES only
+ * the first START_HEX_BYTES and the last END_HEX_BYTES are stored.
+ */
+typedef struct
+{
+    uint32_t total;                 /**< Bytes in the area. */
+    uint16_t head;                  /**< Bytes stored from the start of the
+                                      *  area, the rest are from the end. */
+    uint8_t stride;                 /**< Bytes per line. */
+    uint8_t name_length;            /**< Bytes of the description. */
+} log_hex_t;
+
+/**@brief   The longest description of a hex dump that is stored, in bytes.
+ */
+#define MAX_HEX_NAME            32
+
+/**@brief   A log record with a timestamp.
+ *
+ * Records from interrupts always have a timestamp, the other records only if
+ * LOG_TIMESTAMP is set.
+ */
+typedef struct
+{
+    uint32_t timestamp;             /**< cycles_now() when it was added. */
+    log_record_t record;            /**< The record. */
+} log_stamped_record_t;
+
+/**@brief   A record of the interrupt ring.
+ *
+ * Without LOG_TIMESTAMP the records of the two rings can't be ordered by
+ * time.  An interrupt record keeps the head of the log ring when it was
+ * added instead, and is written once the records added to the log ring
+ * before it have been written.
+ */
+typedef struct
+{
+#if !LOG_TIMESTAMP
+    uint32_t position;              /**< m_log_ring.head when it was added. */
+#endif
+    log_stamped_record_t stamped;   /**< The record and its timestamp. */
+} log_isr_record_t;
+
+/**@brief   Get the raw arguments or the text that follow a record.
+ */
+#define LOG_RECORD_DATA(p_record)   ((uintptr_t *)((p_record) + 1))
+
+/**@brief   Get the start of the log ring entry holding a record added with
+ *          _reserve_record().
+ */
+#if LOG_TIMESTAMP
+#define LOG_RECORD_ENTRY(p_record)                                              \
+    ((void *)((uint8_t *)(p_record) - offsetof(log_stamped_record_t, record)))
+#else
+#define LOG_RECORD_ENTRY(p_record)  ((void *)(p_record))
+#endif
+
+/**@brief   A time since boot.
+ */
+typedef struct
+{
+    uint32_t seconds;               /**< Whole seconds. */
+    uint32_t us;                    /**< Microseconds, less than 1000000. */
+} log_time_t;
+
+/**@brief   Storage for the log ring.
+ */
+static uint8_t m_log_ring_buffer[LOG_RING_SIZE] __attribute__((aligned(4)));
+
+/**@brief   The ring used to pass records to the log task.
+ */
+static log_ring_t m_log_ring;
+
+/**@brief   Storage for the log ring used by interrupts.
+ */
+static uint8_t m_log_isr_ring_buffer[LOG_ISR_RING_SIZE] __attribute__((aligned(4)));
+
+/**@brief   The ring used to pass log_isr_record_t records from interrupts to
+ *          the log task.
+ *
+ * Interrupts use their own ring so that a burst of messages from the tasks
+ * can't stop interrupts from being traced.  The ring is lock-free, so any
+ * number of nested interrupts can add records to it.
+ */
+static log_ring_t m_log_isr_ring;
+
+/**@brief   The counters of the module, updated atomically by the producers.
+ */
+static log_stats_t m_stats;
+
+/**@brief   The counters when the log task last reported them.
+ */
+static log_stats_t m_reported;
+
+/**@brief   What a producer does when the log ring is full.
+ */
+static log_overflow_t m_overflow_policy = LOG_OVERFLOW_POLICY;
+
+/**@brief   The longest time a producer waits for room with
+ *          LOG_OVERFLOW_BLOCK, in milliseconds.
+ */
+static uint32_t m_overflow_timeout_ms = LOG_OVERFLOW_TIMEOUT_MS;
+
+/**@brief   The time since boot in milliseconds, updated with m_time.
+ */
+static uint32_t m_time_ms;
+
+/**@brief   m_time_ms when the log task last reported the dropped messages.
+ */
+static uint32_t m_report_ms;
+
+#if LOG_COLLAPSE_REPEATS
+/**@brief   A copy of the last message that was written, and its arguments or
+ *          text.
+ */
+static uint32_t m_last_record[(sizeof(log_record_t) + MAX_LOG_ENTRY + 3) / 4];
+
+/**@brief   The number of bytes in m_last_record, 0 if there is no message to
+ *          compare with.
+ */
+static size_t m_last_size;
+
+/**@brief   The number of times m_last_record was repeated since it was
+ *          written, or the count was last reported.
+ */
+static uint32_t m_repeated;
+#endif  // LOG_COLLAPSE_REPEATS
+
+/**@brief   Set to true while the log task is waiting for a record.
+ */
+static bool m_log_task_waiting = false;
+
+/**@brief   The cycle counter value when m_time was last updated.
+ */
+static uint32_t m_time_cycles;
 
-/**@brief   The maximum number of log entries that can be stored.
+/**@brief   The time since boot when m_time_cycles was read.
+ *
+ * The log task updates it every time it runs, at least every
+ * LOG_ISR_POLL_TICKS, so that timestamps can be extended past the 32-bit
+ * wrap around of the cycle counter.
  */
-#define LOG_QUEUE_ITEM_SIZE     sizeof(log_entry_t)
+static log_time_t m_time;
 
 /**@brief   Set to true when the module has successfully initialized.
  */
 static bool m_initialized = false;
 
+/**@brief   The command line being received from the host.
+ */
+static char m_command[LOG_COMMAND_SIZE];
+
+/**@brief   The number of bytes in m_command, LOG_COMMAND_SIZE while the rest
+ *          of a line that is too long is skipped.
+ */
+static size_t m_command_length;
+
 
 /**@brief   Internal function used to write a string to the output device.
  *
  * @param   str[in]     A pointer to the buffer of characters to write.
  * @param   len[in]     The number of characters to write.
  */
-static void _output_str(const char *str, uint8_t len)
+static void _output_str(const char *str, size_t len)
 {
-#if LOG_BACKEND_RTT
-    (void)len; // unused
-
-    SEGGER_RTT_WriteString(RTT_TERMINAL_ID, str);
-#endif
-#if LOG_BACKEND_UART
-    MX_USART2_Write((unsigned char *)str, len);
-#endif
-#if LOG_BACKEND_STDIO
-    printf("%s", str);
-#endif
+    log_backend_write(str, len);
+    log_persist_write(str, len);
 }
 
 
-static void _process_log_entry(log_entry_t * p_msg)
+/**@brief   Internal function used to write a block that may be larger than
+ *          the output buffer to the output device.
+ *
+ * Only the log task may call this function.  It waits for room in the output
+ * buffer, and drops the rest of the block if there is no progress for
+ * LOG_BLOCK_TIMEOUT_TICKS, e.g. when no host is reading the RTT buffer.
+ *
+ * @param   str[in]     A pointer to the bytes to write.
+ * @param   len[in]     The number of bytes to write.
+ */
+static void _output_block(const char *str, size_t len)
 {
-    const char * spacer = ": ";
+    uint32_t idle = 0;
 
-    if (!p_msg->raw)
+    while (len && (idle < LOG_BLOCK_TIMEOUT_TICKS))
     {
-        // normal log format: LEVEL: MODULE: buffer
+        size_t size;
+        uint32_t state;
+        char *span = log_backend_reserve(&size, &state);
 
-        // LEVEL
-        if (p_msg->level >= LOG_LEVEL_End)
+        if (NULL == span)
         {
-            p_msg->level = LOG_LEVEL_End;
+            _output_str(str, len);
+            return;
         }
 
-        _output_str(
-            m_level_str[p_msg->level],
-            strlen(m_level_str[p_msg->level])
-        );
-        _output_str(spacer, strlen(spacer));
-
-        // MODULE
-        _output_str(p_msg->module, strlen(p_msg->module));
-        _output_str(spacer, strlen(spacer));
-    }
-
-    // buffer
-    _output_str(p_msg->buffer, strlen(p_msg->buffer));
-}
-
-
-static void _process_log(bool emergency)
-{
-    bool done = false;
-    osStatus_t ret;
+        if (size > len)
+        {
+            size = len;
+        }
+        memcpy(span, str, size);
+        log_backend_commit(size, state);
 
-    while (!done)
-    {
-        log_entry_t msg;
+        str += size;
+        len -= size;
 
-        if (emergency)
+        if (0 == size)
         {
-            ret = osMessageQueueGet(m_log_queue_handle, &msg, NULL, 0);
+            osDelay(1);
+            idle++;
         }
         else
         {
-            ret = osMessageQueueGet(m_log_queue_handle, &msg, NULL, osWaitForever);
-        }
-        switch (ret)
-        {
-        case osOK:
-            _process_log_entry(&msg);
-            if (0 == osMessageQueueGetCount(m_log_queue_handle))
-            {
-                done = true;
-            }
-            break;
-
-        case osErrorParameter:
-            debug_pulse(DEBUG_PIN_4, 0, 1);
-            done = true;
-            break;
-        case osErrorResource:
-            debug_pulse(DEBUG_PIN_4, 0, 2);
-            done = true;
-            break;
-        case osErrorTimeout:
-            debug_pulse(DEBUG_PIN_4, 0, 3);
-            done = true;
-            break;
-        default:
-            debug_pulse(DEBUG_PIN_4, 0, 4);
-            done = true;
-            break;
+            idle = 0;
         }
     }
 }
 
 
-/**@brief   Function to test if an OS call was successful.
- *
- * If it wasn't, it directly dumps a message out to the RTT or UART.
- * This is intended to only be used internally in this module.
- * All other modules should use the logging module to report errors.
+#if LOG_DICTIONARY
+/**@brief   Internal function used to write a frame to the output device.
  *
- * @param   ret[in]             The OS return code to test.
- * @param   description[in]     A short description of the OS call.
+ * The frame is written with a single call so that it is either completely
+ * written or dropped by the RTT.
  *
- * @return  The function returns true if the OS call was successful, false
- *          otherwise.
+ * @param   type[in]    The LOG_FRAME_* type of the frame.
+ * @param   info[in]    The log level and LOG_FRAME_RAW bit.
+ * @param   module[in]  The module string, may be NULL.
+ * @param   p_data[in]  The rest of the payload.
+ * @param   length[in]  The number of bytes in p_data, it will be truncated to
+ *                      fit in the frame.
  */
-static bool log_os_success(osStatus_t ret, const char *description)
+static void _output_frame(
+    uint8_t type,
+    uint8_t info,
+    const char *module,
+    const void *p_data,
+    size_t length
+)
 {
-    if (osOK != ret)
+    uint8_t frame[LOG_FRAME_HEADER + LOG_FRAME_MAX_PAYLOAD];
+    uint32_t id = (uint32_t)(uintptr_t)module;
+
+    if (length > LOG_FRAME_MAX_PAYLOAD - sizeof(id))
     {
-        char buffer[MAX_LOG_ENTRY];
-        sprintf(buffer, "!! Log Error, message dump:\n");
-        _output_str(buffer, strlen(buffer));
-        _process_log(true);
-        sprintf(buffer, "!! Log Error: %s returned %d\n", description, ret);
-        _output_str(buffer, strlen(buffer));
-        return false;
+        length = LOG_FRAME_MAX_PAYLOAD - sizeof(id);
     }
-    return true;
+
+    frame[0] = type;
+    frame[1] = info;
+    frame[2] = sizeof(id) + length;
+    memcpy(&frame[LOG_FRAME_HEADER], &id, sizeof(id));
+    memcpy(&frame[LOG_FRAME_HEADER + sizeof(id)], p_data, length);
+
+    _output_str((const char *)frame, LOG_FRAME_HEADER + sizeof(id) + length);
 }
+#endif  // LOG_DICTIONARY
 
-void log_dump(void)
+
+/**@brief   Internal function used to write a message from this module directly
+ *          to the output device, bypassing the ring.
+ *
+ * @param   msg[in]     The NULL terminated message to write.
+ */
+static void _output_message(const char *msg)
 {
-    _process_log(true);
+#if LOG_DICTIONARY
+    _output_frame(LOG_FRAME_TEXT, LOG_FRAME_RAW | LOG_FRAME_NO_LEVEL, NULL,
+                  msg, strlen(msg));
+#else
+    _output_str(msg, strlen(msg));
+#endif
 }
 
-/**@brief   FreeRTOS task that empties the queue to the output device.
+
+/**@brief   Internal function used to terminate a truncated message with a
+ *          newline.
+ *
+ * @param   buffer[in]  The buffer holding the formatted message.
+ * @param   size[in]    The size of the buffer in bytes.
+ * @param   written[in] The value returned by the printf function.
  */
-static void log_task(void * argumnet)
+static void _mark_truncated(char *buffer, size_t size, int written)
 {
-    for (;;)
+    if (written >= (int)size)
     {
-        _process_log(false);
+        // We truncated the output, add a \n before the null terminator
+        buffer[size - 2] = '\n';
     }
 }
 
 
-/**@brief   Run the module unit tests is UNIT_TEST is non-zero.
+/**@brief   Internal function used to test if the caller is an interrupt.
  *
- *  This unit test is different in that we don't use the LOG_TEST macro as
- *  we're testing the log macros themselves.
+ * @return  True if called from an interrupt or exception handler.
  */
-static void _unit_test(void)
+static inline bool _in_isr(void)
 {
-#if UNIT_TEST
-    // This message should not log since the module log level is set to
-    // LOG_LEVEL_INFO
-    LOG_DEBUG("!!! You shouldn't see this message !!!\n");
-
-    // These messages should appear in the log
-    LOG_INFO("Info\n");
-    LOG_WARNING("Warning\n");
-    LOG_ERROR("Error\n");
-    LOG_CRITICAL("Critical\n");
-
-    LOG_INFO("%d items %s\n", 7, "loaded");
-    LOG_WARNING(
-        "Truncated message: %s",
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-        "0123456789 "
-    );
+    return 0 != __get_IPSR();
+}
 
-    char test[80];
 
-    for (int i = 0; i < 80; i++)
+/**@brief   Internal function used to update m_time with the cycle counter.
+ *
+ * Only the log task, or log_dump(), may call this function.
+ */
+static void _update_time(void)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t us = (cycles_now() - m_time_cycles) / cycles_per_us;
+
+    // Keep the cycles that don't add up to a whole microsecond for the next
+    // update.
+    m_time_cycles += us * cycles_per_us;
+    m_time.us += us;
+    while (m_time.us >= 1000000)
     {
-        test[i] = i;
+        m_time.us -= 1000000;
+        m_time.seconds++;
     }
 
-    LOG_HEX_INFO("Test data", test, 20, 16);
-    LOG_RAW_HEX_INFO(NULL, test, 20, 8);
-    LOG_RAW_HEX_INFO("Too large of an area", test, 80, 16);
-#endif
+    __atomic_store_n(&m_time_ms, m_time.seconds * 1000 + m_time.us / 1000,
+                     __ATOMIC_RELAXED);
 }
 
 
-void log_task_init(void)
+/**@brief   Internal function used to convert a record timestamp to the time
+ *          since boot.
+ *
+ * The timestamp must be within 2^31 cycles of the last _update_time(), a few
+ * seconds at the core clock.
+ *
+ * @param   timestamp[in]   The cycle counter value of the record.
+ * @param   p_time[out]     Set to the time since boot of the record.
+ */
+static void _timestamp_to_time(uint32_t timestamp, log_time_t *p_time)
 {
-#if LOG_BACKEND_RTT
-    SEGGER_RTT_Init();
-#endif
+    int32_t cycles_per_us = SystemCoreClock / 1000000;
+    int32_t us = (int32_t)m_time.us +
+                 (int32_t)(timestamp - m_time_cycles) / cycles_per_us;
 
-    m_log_task_handle = osThreadNew(log_task, NULL, &m_log_task_attributes);
-    if (NULL == m_log_task_handle)
+    p_time->seconds = m_time.seconds;
+    while (us < 0)
     {
-        const char *msg = "ERROR - creating log task\n";
-        _output_str(msg, strlen(msg));
-        return;
+        us += 1000000;
+        p_time->seconds--;
     }
-
-    m_log_queue_handle = osMessageQueueNew(LOG_QUEUE_EVENTS,
-                                           LOG_QUEUE_ITEM_SIZE,
-                                           &m_log_queue_attributes);
-    if (NULL == m_log_queue_handle)
+    while (us >= 1000000)
     {
-        const char *msg = "ERROR - creating log queue\n";
-        _output_str(msg, strlen(msg));
-        return;
+        us -= 1000000;
+        p_time->seconds++;
     }
-
-    m_initialized = true;
-    LOG_INFO("Initialized\n");
-
-    _unit_test();
+    p_time->us = us;
 }
 
 
-void log_entry(
-    log_level_t level,
-    const char *module,
-    bool raw,
-    const char *file,
-    int line,
-    const char *fmt,
-    ...
-)
+#if !LOG_DICTIONARY
+/**@brief   Internal function used to append formatted text to a buffer.
+ *
+ * @param   buffer[in]      The buffer to append to.
+ * @param   size[in]        The size of the buffer in bytes.
+ * @param   p_length[inout] The number of bytes in the buffer.  It's updated
+ *                          with the number of bytes the text needs, even if
+ *                          they don't fit.
+ * @param   fmt[in]         A printf format string.
+ */
+static void _append(char *buffer, size_t size, size_t *p_length, const char *fmt, ...)
 {
-    if (!m_initialized)
-    {
-        char *msg = "!! Log module not initialized\n";
-        _output_str(msg, strlen(msg));
-        return;
-    }
-
-    log_entry_t msg =
-    {
-        .level = level,
-        .module = module,
-        .raw = raw,
-    };
     va_list ap;
+    char *p_start = NULL;
+    size_t left = 0;
 
-    // NOTE: file and line are currently unused, but would be easy to enable
-    //       that functionality if desired.
-    (void)file; // unused
-    (void)line; // unused
-
-    va_start(ap, fmt);
-    int written = vsnprintf(msg.buffer, sizeof(msg.buffer), fmt, ap);
-    if (written > sizeof(msg.buffer))
+    if (*p_length < size)
     {
-        // We truncated the output, add a \n before the null terminator
-        msg.buffer[MAX_LOG_ENTRY - 2] = '\n';
+        p_start = buffer + *p_length;
+        left = size - *p_length;
     }
+
+    va_start(ap, fmt);
+    int written = log_vsnprintf(p_start, left, fmt, ap);
     va_end(ap);
 
-    osStatus_t ret = osMessageQueuePut(m_log_queue_handle, &msg, 0U, 0U);
-    log_os_success(ret, msg.buffer);
+    if (written > 0)
+    {
+        *p_length += written;
+    }
 }
 
 
-/**@brief   Internal function used to add a hex dump of a memory area to the log queue.
+/**@brief   The digits used by the hex encoder.
+ */
+static const char m_hex_digits[16] = "0123456789abcdef";
+
+
+/**@brief   Internal function used to encode bytes as hex text.
  *
- * This function just dumps raw hex bytes into the queue.  Dumping a large area
- * will overload the queue.
+ * Every byte is written as two digits and a space, and every group of 4
+ * bytes is followed by an extra space.  Whole groups are encoded a 32-bit
+ * word at a time.
  *
- * @param[in] level     The log level of the entry.
- * @param[in] module    The value of LOG_MODULE_NAME of the entry.
- * @param[in] file      The file containing the entry.
- * @param[in] line      The line of the file that the entry starts at.
- * @param[in] p_data    Pointer to data to print.
- * @param[in] length    Amount of data to print in bytes.
- * @param[in] stride    Number of bytes to print before a newline.
+ * @param[out] buffer   The buffer to write to, at least 3 * length +
+ *                      length / 4 characters.
+ * @param[in]  p_data   The bytes to encode.
+ * @param[in]  length   The number of bytes to encode.
+ *
+ * @return  The number of characters written.
  */
-static void _internal_dump_hex(
-    log_level_t level,
+static size_t _hex_encode(char *buffer, const uint8_t *p_data, size_t length)
+{
+    char *p_out = buffer;
+    size_t index = 0;
+
+    for (; index + 4 <= length; index += 4)
+    {
+        uint32_t word;
+
+        // The dump may not be word aligned.  The target is little endian, so
+        // the lowest byte of the word is the first byte in memory.
+        memcpy(&word, &p_data[index], sizeof(word));
+
+        for (int byte = 0; byte < 4; byte++)
+        {
+            p_out[0] = m_hex_digits[(word >> 4) & 0x0F];
+            p_out[1] = m_hex_digits[word & 0x0F];
+            p_out[2] = ' ';
+            p_out += 3;
+            word >>= 8;
+        }
+        *p_out++ = ' ';
+    }
+
+    for (; index < length; index++)
+    {
+        p_out[0] = m_hex_digits[p_data[index] >> 4];
+        p_out[1] = m_hex_digits[p_data[index] & 0x0F];
+        p_out[2] = ' ';
+        p_out += 3;
+    }
+
+    return p_out - buffer;
+}
+
+
+/**@brief   Internal function used to format a log record as a line of text.
+ *
+ * The line is formatted as LEVEL: MODULE: [TIMESTAMP] FILE:LINE: MESSAGE,
+ * raw records only have the message.  Messages longer than MAX_LOG_ENTRY are
+ * truncated.  The line is complete only if the value returned is less than
+ * size.
+ *
+ * @param   buffer[out]     The buffer to format the line into.
+ * @param   size[in]        The size of the buffer in bytes.
+ * @param   p_record[in]    The record to format.
+ * @param   p_timestamp[in] The cycle counter timestamp of the record, NULL if
+ *                          the record doesn't have one.
+ *
+ * @return  The number of bytes the line needs, not counting the NULL
+ *          terminator.
+ */
+static size_t _format_record(
+    char *buffer,
+    size_t size,
+    const log_record_t *p_record,
+    const uint32_t *p_timestamp
+)
+{
+    const uintptr_t *data = LOG_RECORD_DATA(p_record);
+    uint8_t level = p_record->level;
+    size_t length = 0;
+
+    if (level >= LOG_LEVEL_End)
+    {
+        level = LOG_LEVEL_End;
+    }
+
+    if (!(p_record->flags & LOG_RECORD_RAW))
+    {
+        // normal log format: LEVEL: MODULE: buffer
+        _append(buffer, size, &length, "%s: %s: ",
+                m_level_str[level], p_record->module);
+
+        if (p_timestamp)
+        {
+            log_time_t time;
+
+            _timestamp_to_time(*p_timestamp, &time);
+            _append(buffer, size, &length, "[%lu.%06lu] ",
+                    (unsigned long)time.seconds, (unsigned long)time.us);
+        }
+
+#if LOG_FILE_LINE
+        if (p_record->file)
+        {
+            _append(buffer, size, &length, "%s:%lu: ",
+                    p_record->file, (unsigned long)p_record->line);
+        }
+#endif
+    }
+
+    if (p_record->fmt)
+    {
+        // Format the message now that we're in the context of the log task.
+        // Unused argument words are zero and ignored by the format string.
+        uintptr_t args[LOG_DEFERRED_MAX_ARGS] = { 0 };
+        size_t limit = (length < size) ? size - length : 0;
+
+        memcpy(args, data, p_record->length * sizeof(uintptr_t));
+
+        if (limit > MAX_LOG_ENTRY)
+        {
+            limit = MAX_LOG_ENTRY;
+        }
+
+        int written = log_snprintf(limit ? buffer + length : NULL, limit,
+                                   p_record->fmt,
+                                   args[0], args[1], args[2], args[3]);
+        if (written >= MAX_LOG_ENTRY)
+        {
+            written = MAX_LOG_ENTRY - 1;
+            if (limit == MAX_LOG_ENTRY)
+            {
+                _mark_truncated(buffer + length, MAX_LOG_ENTRY, MAX_LOG_ENTRY);
+            }
+        }
+        if (written > 0)
+        {
+            length += written;
+        }
+    }
+    else
+    {
+        // The text was already truncated by log_entry(), but a long prefix
+        // may leave less room than that
+        size_t limit = (length < size) ? size - length : 0;
+
+        if (limit > 1)
+        {
+            size_t copy = (p_record->length < limit) ? p_record->length : limit - 1;
+
+            memcpy(buffer + length, data, copy);
+            buffer[length + copy] = '\0';
+            _mark_truncated(buffer + length, limit, p_record->length);
+        }
+        length += p_record->length;
+    }
+
+    return length;
+}
+#endif  // !LOG_DICTIONARY
+
+
+#if LOG_DICTIONARY
+/**@brief   Internal function used to start the payload of the frame of a log
+ *          record.
+ *
+ * @param[in]  p_record     The record to write.
+ * @param[in]  p_timestamp  The cycle counter timestamp of the record, NULL if
+ *                          the record doesn't have one.
+ * @param[out] p_info       Set to the info byte of the frame.
+ * @param[out] payload      Set to the timestamp and the file and line words
+ *                          of the payload.
+ *
+ * @return  The number of words written to payload.
+ */
+static size_t _frame_prefix(
+    const log_record_t *p_record,
+    const uint32_t *p_timestamp,
+    uint8_t *p_info,
+    uint32_t *payload
+)
+{
+    uint8_t level = p_record->level;
+    size_t count = 0;
+
+    if (level >= LOG_LEVEL_End)
+    {
+        level = LOG_LEVEL_End;
+    }
+
+    *p_info = level | ((p_record->flags & LOG_RECORD_RAW) ? LOG_FRAME_RAW : 0);
+
+    if (p_timestamp && !(p_record->flags & LOG_RECORD_RAW))
+    {
+        log_time_t time;
+
+        _timestamp_to_time(*p_timestamp, &time);
+        *p_info |= LOG_FRAME_TIMESTAMP;
+        payload[count++] = time.seconds;
+        payload[count++] = time.us;
+    }
+
+#if LOG_FILE_LINE
+    if (p_record->file && !(p_record->flags & LOG_RECORD_RAW))
+    {
+        *p_info |= LOG_FRAME_FILE_LINE;
+        payload[count++] = (uint32_t)(uintptr_t)p_record->file;
+        payload[count++] = p_record->line;
+    }
+#endif
+
+    return count;
+}
+#endif  // LOG_DICTIONARY
+
+
+/**@brief   Internal function used to write a log record to the output
+ *          device.
+ *
+ * @param   p_record[in]    The record to write.
+ * @param   p_timestamp[in] The cycle counter timestamp of the record, NULL if
+ *                          the record doesn't have one.
+ */
+static void _process_log_entry(
+    const log_record_t *p_record,
+    const uint32_t *p_timestamp
+)
+{
+#if LOG_DICTIONARY
+    const uintptr_t *data = LOG_RECORD_DATA(p_record);
+    const char *text = (const char *)data;
+
+    // The strings aren't on the target, send the IDs and let the host format
+    // the message.
+    uint8_t info;
+    uint32_t payload[LOG_FRAME_MAX_PAYLOAD / sizeof(uint32_t)];
+    size_t count = _frame_prefix(p_record, p_timestamp, &info, payload);
+    size_t length;
+
+    if (p_record->fmt)
+    {
+        payload[count++] = (uint32_t)(uintptr_t)p_record->fmt;
+        for (int i = 0; i < p_record->length; i++)
+        {
+            payload[count++] = (uint32_t)data[i];
+        }
+
+        _output_frame(LOG_FRAME_FORMAT, info, p_record->module,
+                      payload, count * sizeof(uint32_t));
+    }
+    else
+    {
+        length = sizeof(payload) - count * sizeof(uint32_t);
+        if (length > p_record->length)
+        {
+            length = p_record->length;
+        }
+        memcpy(&payload[count], text, length);
+
+        _output_frame(LOG_FRAME_TEXT, info, p_record->module,
+                      payload, count * sizeof(uint32_t) + length);
+    }
+#else
+    // The line is formatted outside of the backend lock, which masks the
+    // interrupts up to SEGGER_RTT_MAX_INTERRUPT_PRIORITY.  The lock is only
+    // held to copy the line to the output buffer.
+    char buffer[MAX_LOG_LINE];
+    size_t length;
+
+    length = _format_record(buffer, sizeof(buffer), p_record, p_timestamp);
+    if (length >= sizeof(buffer))
+    {
+        length = sizeof(buffer) - 1;
+        buffer[length - 1] = '\n';
+    }
+    _output_str(buffer, length);
+#endif  // LOG_DICTIONARY
+}
+
+
+/**@brief   Internal function used to write a hex dump record to the output
+ *          device.
+ *
+ * In dictionary mode the bytes are sent in LOG_FRAME_HEX frames that hold
+ * whole lines, otherwise every line is formatted and written as a text
+ * record.
+ *
+ * @param   p_record[in]    The record to write.
+ * @param   p_timestamp[in] The cycle counter timestamp of the record, NULL if
+ *                          the record doesn't have one.
+ */
+static void _process_hex_record(
+    const log_record_t *p_record,
+    const uint32_t *p_timestamp
+)
+{
+    const log_hex_t *p_hex = (const log_hex_t *)LOG_RECORD_DATA(p_record);
+    const uint8_t *p_name = (const uint8_t *)(p_hex + 1);
+    const uint8_t *p_bytes = p_name + p_hex->name_length;
+    size_t stored = p_record->length - sizeof(log_hex_t) - p_hex->name_length;
+    size_t offset = 0;
+
+#if LOG_DICTIONARY
+    uint8_t info;
+    uint32_t payload[LOG_FRAME_MAX_PAYLOAD / sizeof(uint32_t)];
+    size_t count = _frame_prefix(p_record, p_timestamp, &info, payload);
+    uint8_t *p_frame = (uint8_t *)&payload[count];
+    size_t room = LOG_FRAME_MAX_PAYLOAD - sizeof(uint32_t) -
+                  count * sizeof(uint32_t) - LOG_FRAME_HEX_HEADER -
+                  p_hex->name_length;
+
+    // Only send whole lines in a frame, so the decoder doesn't need to keep
+    // partial lines
+    room -= room % p_hex->stride;
+
+    do
+    {
+        size_t end = (offset < p_hex->head) ? p_hex->head : stored;
+        size_t length = (end - offset < room) ? end - offset : room;
+        uint32_t position = (offset < p_hex->head) ?
+                            offset : p_hex->total - (stored - offset);
+        uint8_t name_length = (0 == offset) ? p_hex->name_length : 0;
+
+        memcpy(&p_frame[0], &p_hex->total, sizeof(uint32_t));
+        memcpy(&p_frame[4], &position, sizeof(uint32_t));
+        p_frame[8] = p_hex->stride;
+        p_frame[9] = name_length;
+        memcpy(&p_frame[LOG_FRAME_HEX_HEADER], p_name, name_length);
+        memcpy(&p_frame[LOG_FRAME_HEX_HEADER + name_length], &p_bytes[offset],
+               length);
+
+        _output_frame(LOG_FRAME_HEX, info, p_record->module, payload,
+                      count * sizeof(uint32_t) + LOG_FRAME_HEX_HEADER +
+                      name_length + length);
+        offset += length;
+    } while (offset < stored);
+#else
+    struct
+    {
+        log_record_t record;
+        char text[MAX_LOG_ENTRY];
+    } line;
+    unsigned long total = p_hex->total;
+    size_t end = p_hex->head;
+    int written;
+
+    // Every line is a text record with the level, module, timestamp and file
+    // and line of the dump
+    line.record = *p_record;
+    line.record.flags &= ~LOG_RECORD_HEX;
+
+    if (p_hex->name_length)
+    {
+        written = log_snprintf(line.text, sizeof(line.text),
+                               "%.*s (%lu byte%s)\n",
+                               (int)p_hex->name_length, (const char *)p_name,
+                               total, (total != 1) ? "s" : "");
+    }
+    else
+    {
+        written = log_snprintf(line.text, sizeof(line.text), "(%lu byte%s)\n",
+                               total, (total != 1) ? "s" : "");
+    }
+    line.record.length = written;
+    _process_log_entry(&line.record, p_timestamp);
+
+    while (offset < stored)
+    {
+        if (offset == end)
+        {
+            // The middle of a large area isn't stored
+            memcpy(line.text, "...\n", 4);
+            line.record.length = 4;
+            _process_log_entry(&line.record, p_timestamp);
+            end = stored;
+        }
+
+        size_t length = (end - offset < p_hex->stride) ?
+                        end - offset : p_hex->stride;
+
+        written = _hex_encode(line.text, &p_bytes[offset], length);
+        line.text[written++] = '\n';
+        line.record.length = written;
+        _process_log_entry(&line.record, p_timestamp);
+
+        offset += length;
+    }
+#endif  // LOG_DICTIONARY
+}
+
+
+/**@brief   Internal function used to report the records that were dropped
+ *          because the ring was full or the call was rate limited.
+ */
+static void _report_dropped(void)
+{
+    log_stats_t stats;
+
+    log_stats_get(&stats);
+
+    uint32_t dropped = (stats.dropped_newest - m_reported.dropped_newest) +
+                       (stats.dropped_oldest - m_reported.dropped_oldest) +
+                       (stats.timed_out - m_reported.timed_out);
+    uint32_t limited = stats.rate_limited - m_reported.rate_limited;
+
+    m_reported = stats;
+
+    if (dropped || limited)
+    {
+        char buffer[64];
+        log_snprintf(buffer, sizeof(buffer),
+                     "!! %lu log messages dropped, %lu rate limited\n",
+                     (unsigned long)dropped, (unsigned long)limited);
+        _output_message(buffer);
+    }
+}
+
+
+/**@brief   Internal function used to report how many times the last message
+ *          was repeated.
+ */
+static void _report_repeated(void)
+{
+#if LOG_COLLAPSE_REPEATS
+    if (m_repeated)
+    {
+        char buffer[48];
+        log_snprintf(buffer, sizeof(buffer),
+                     "Last message repeated %lu times\n",
+                     (unsigned long)m_repeated);
+        _output_message(buffer);
+        m_repeated = 0;
+    }
+#endif
+}
+
+
+#if LOG_COLLAPSE_REPEATS
+/**@brief   Internal function used to compare two records.
+ *
+ * Only the fields are compared, not the padding of the header.
+ *
+ * @param   p_a[in]     A record.
+ * @param   p_b[in]     The other record.
+ *
+ * @return  True if the records hold the same message.
+ */
+static bool _same_record(const log_record_t *p_a, const log_record_t *p_b)
+{
+    if ((p_a->level != p_b->level) || (p_a->flags != p_b->flags) ||
+        (p_a->length != p_b->length) || (p_a->module != p_b->module) ||
+        (p_a->fmt != p_b->fmt))
+    {
+        return false;
+    }
+
+#if LOG_FILE_LINE
+    if ((p_a->file != p_b->file) || (p_a->line != p_b->line))
+    {
+        return false;
+    }
+#endif
+
+    size_t size = p_a->fmt ? p_a->length * sizeof(uintptr_t) : p_a->length;
+
+    return 0 == memcmp(LOG_RECORD_DATA(p_a), LOG_RECORD_DATA(p_b), size);
+}
+
+
+/**@brief   Internal function used to test if the format of a record has a
+ *          %s argument.
+ *
+ * The argument is a pointer to a string that may have changed since the
+ * last message, so the record can't be compared with it.  In dictionary
+ * mode the format isn't on the target, the host reads the strings from the
+ * ELF file so the pointer is what's printed.
+ *
+ * @param   p_record[in]    The record.
+ *
+ * @return  True if the record has a %s argument.
+ */
+static bool _has_string_arg(const log_record_t *p_record)
+{
+#if !LOG_DICTIONARY
+    const char *fmt = p_record->fmt;
+
+    while (fmt && (NULL != (fmt = strchr(fmt, '%'))))
+    {
+        // Skip the flags, the width, the precision and the length
+        fmt++;
+        fmt += strspn(fmt, "-+ #0123456789.*hlLjzt");
+        if ('s' == *fmt)
+        {
+            return true;
+        }
+        if ('\0' != *fmt)
+        {
+            fmt++;
+        }
+    }
+#endif
+
+    return false;
+}
+#endif  // LOG_COLLAPSE_REPEATS
+
+
+/**@brief   Internal function used to test if a record repeats the last
+ *          message that was written.
+ *
+ * If it doesn't, the repeat count of the last message is reported and the
+ * record becomes the last message.
+ *
+ * @param   p_record[in]    The record to test.
+ *
+ * @return  True if the record is a repeat and must not be written.
+ */
+static bool _is_repeat(const log_record_t *p_record)
+{
+#if LOG_COLLAPSE_REPEATS
+    size_t size = sizeof(log_record_t) +
+        (p_record->fmt ? p_record->length * sizeof(uintptr_t) : p_record->length);
+
+    if (!(p_record->flags & LOG_RECORD_RAW) && (size == m_last_size) &&
+        _same_record((const log_record_t *)m_last_record, p_record) &&
+        !_has_string_arg(p_record))
+    {
+        m_repeated++;
+        return true;
+    }
+
+    _report_repeated();
+
+    // Raw messages are often parts of a line or a table and repeat on purpose
+    m_last_size = 0;
+    if (!(p_record->flags & LOG_RECORD_RAW) && (size <= sizeof(m_last_record)))
+    {
+        memcpy(m_last_record, p_record, size);
+        m_last_size = size;
+    }
+#endif
+
+    return false;
+}
+
+
+/**@brief   Internal function used to write a log record to the output device
+ *          unless it repeats the last message.
+ *
+ * @param   p_record[in]    The record to write.
+ * @param   p_timestamp[in] The cycle counter timestamp of the record, NULL if
+ *                          the record doesn't have one.
+ */
+static void _write_record(
+    const log_record_t *p_record,
+    const uint32_t *p_timestamp
+)
+{
+    if (_is_repeat(p_record))
+    {
+        return;
+    }
+
+    if (p_record->flags & LOG_RECORD_HEX)
+    {
+        _process_hex_record(p_record, p_timestamp);
+    }
+    else
+    {
+        _process_log_entry(p_record, p_timestamp);
+    }
+}
+
+
+/**@brief   Internal function used to write all of the committed records to
+ *          the output device.
+ *
+ * @param   emergency[in]   Set to true when called from a fault or error
+ *                          handler.  The ring is read even if the log task
+ *                          was stopped while reading it, it won't run again.
+ *
+ * @return  False if the ring lock is held by a producer dropping the oldest
+ *          records, or an interrupt record waits for a record of the log
+ *          ring that isn't committed yet, true otherwise.
+ */
+static bool _process_log(bool emergency)
+{
+    bool locked = log_ring_lock(&m_log_ring);
+    bool waiting = false;
+
+    if (!locked && !emergency)
+    {
+        return false;
+    }
+
+    _update_time();
+
+    // The log ring lock also protects the interrupt ring, interrupts never
+    // read it.
+    for (;;)
+    {
+        log_isr_record_t *p_isr = log_ring_peek(&m_log_isr_ring, NULL);
+        void *p_entry = log_ring_peek(&m_log_ring, NULL);
+
+        if ((NULL == p_isr) && (NULL == p_entry))
+        {
+            break;
+        }
+
+#if LOG_TIMESTAMP
+        log_stamped_record_t *p_stamped = p_entry;
+
+        // Both rings have timestamps, write the oldest record first
+        if (p_isr && (!p_stamped ||
+                      (int32_t)(p_isr->stamped.timestamp - p_stamped->timestamp) <= 0))
+        {
+            _write_record(&p_isr->stamped.record, &p_isr->stamped.timestamp);
+            log_ring_release(&m_log_isr_ring);
+        }
+        else
+        {
+            _write_record(&p_stamped->record, &p_stamped->timestamp);
+            log_ring_release(&m_log_ring);
+        }
+#else
+        // Write the records in the order they were added, an interrupt
+        // record once the log ring tail has passed its position
+        if (p_isr && (int32_t)(p_isr->position - m_log_ring.tail) <= 0)
+        {
+            _write_record(&p_isr->stamped.record, &p_isr->stamped.timestamp);
+            log_ring_release(&m_log_isr_ring);
+        }
+        else if (p_entry)
+        {
+            _write_record(p_entry, NULL);
+            log_ring_release(&m_log_ring);
+        }
+        else if (emergency)
+        {
+            // The record before it was never committed, it never will be
+            _write_record(&p_isr->stamped.record, &p_isr->stamped.timestamp);
+            log_ring_release(&m_log_isr_ring);
+        }
+        else
+        {
+            // Wait for the record before it to be committed
+            waiting = true;
+            break;
+        }
+#endif
+    }
+
+    // Report the lost messages now and then, so that a flood of messages
+    // doesn't also flood the output with reports.
+    if (emergency ||
+        ((uint32_t)(m_time_ms - m_report_ms) >= LOG_REPORT_PERIOD_MS))
+    {
+        _report_repeated();
+        _report_dropped();
+        m_report_ms = m_time_ms;
+    }
+
+    if (locked)
+    {
+        log_ring_unlock(&m_log_ring);
+    }
+
+    return !waiting;
+}
+
+
+void log_dump(void)
+{
+    _process_log(true);
+    log_backend_flush();
+}
+
+/**@brief   Internal function used to run the commands sent by the host.
+ *
+ * The bytes received by the backend are collected into lines, and every line
+ * is run with log_level_command().
+ */
+static void _poll_commands(void)
+{
+    char input[16];
+    size_t count;
+
+    while (0 != (count = log_backend_read(input, sizeof(input))))
+    {
+        for (size_t index = 0; index < count; index++)
+        {
+            char c = input[index];
+
+            if (('\r' != c) && ('\n' != c))
+            {
+                if (m_command_length < (LOG_COMMAND_SIZE - 1))
+                {
+                    m_command[m_command_length++] = c;
+                }
+                else
+                {
+                    m_command_length = LOG_COMMAND_SIZE;
+                }
+            }
+            else if (m_command_length == LOG_COMMAND_SIZE)
+            {
+                LOG_WARNING("Command too long\n");
+                m_command_length = 0;
+            }
+            else if (0 != m_command_length)
+            {
+                m_command[m_command_length] = '\0';
+                m_command_length = 0;
+
+                if (!log_level_command(m_command))
+                {
+                    LOG_WARNING("Invalid command, use \"log list\", "
+                                "\"log stats\" or \"log <module> <level>\"\n");
+                }
+            }
+        }
+    }
+}
+
+
+/**@brief   FreeRTOS task that empties the ring to the output device.
+ */
+static void log_task(void * argumnet)
+{
+    // Write the log of the previous boot before anything else is added to the
+    // persistent ring.
+    if (log_persist_init())
+    {
+        _output_message("---- Log of the previous boot ----\n");
+        log_persist_replay(_output_block);
+        _output_message("---- End of the log of the previous boot ----\n");
+    }
+    log_persist_start();
+
+    for (;;)
+    {
+        if (!_process_log(false))
+        {
+            // Let the producer that holds the lock, or that hasn't
+            // committed its record yet, finish.  It may have a lower
+            // priority.
+            osDelay(1);
+            continue;
+        }
+        _poll_commands();
+
+        // Producers only wake the task while m_log_task_waiting is set, so
+        // check the ring again after setting it in case a record was
+        // committed in between.  The fence pairs with the one in
+        // _commit_record().
+        __atomic_store_n(&m_log_task_waiting, true, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if (!log_ring_readable(&m_log_ring) &&
+            !log_ring_readable(&m_log_isr_ring))
+        {
+            osThreadFlagsWait(LOG_TASK_FLAG_RECORD, osFlagsWaitAny,
+                              LOG_ISR_POLL_TICKS);
+        }
+
+        __atomic_store_n(&m_log_task_waiting, false, __ATOMIC_RELAXED);
+    }
+}
+
+
+/**@brief   Run the module unit tests is UNIT_TEST is non-zero.
+ *
+ *  This unit test is different in that we don't use the LOG_TEST macro as
+ *  we're testing the log macros themselves.
+ */
+static void _unit_test(void)
+{
+#if UNIT_TEST
+    // This message should not log since the module log level is set to
+    // LOG_LEVEL_INFO
+    LOG_DEBUG("!!! You shouldn't see this message !!!\n");
+
+    // These messages should appear in the log
+    LOG_INFO("Info\n");
+    LOG_WARNING("Warning\n");
+    LOG_ERROR("Error\n");
+    LOG_CRITICAL("Critical\n");
+
+    LOG_INFO("%d items %s\n", 7, "loaded");
+    LOG_ISR_INFO("Interrupt path: %d items\n", 3);
+    LOG_WARNING(
+        "Truncated message: %s",
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+        "0123456789 "
+    );
+
+    char test[80];
+
+    for (int i = 0; i < 80; i++)
+    {
+        test[i] = i;
+    }
+
+#if LOG_RUNTIME_LEVEL
+    // Only the message logged while the level is lowered should appear
+    log_level_set(STRINGIFY(LOG_MODULE_NAME), LOG_LEVEL_DEBUG);
+    LOG_DEBUG("Debug enabled at run time\n");
+    log_level_command("log log info");
+    LOG_DEBUG("!!! You shouldn't see this message !!!\n");
+    log_level_command("log list");
+#endif
+
+    // Only the first message should appear, followed by a repeat count of 4
+    for (int i = 0; i < 5; i++)
+    {
+        LOG_INFO("Repeated message\n");
+    }
+
+#if LOG_RATE_LIMIT
+    // Only the first LOG_RATE_BURST messages should appear, the rest are
+    // reported as rate limited.
+    for (int i = 0; i < LOG_RATE_BURST + 5; i++)
+    {
+        LOG_INFO("Storm %d\n", i);
+    }
+#endif
+
+    LOG_HEX_INFO("Test data", test, 20, 16);
+    LOG_RAW_HEX_INFO(NULL, test, 20, 8);
+    LOG_RAW_HEX_INFO("Too large of an area", test, 80, 16);
+#endif
+}
+
+
+void log_overflow_set(log_overflow_t policy, uint32_t timeout_ms)
+{
+    m_overflow_timeout_ms = timeout_ms;
+    m_overflow_policy = policy;
+}
+
+
+void log_stats_get(log_stats_t *p_stats)
+{
+    p_stats->dropped_newest = __atomic_load_n(&m_stats.dropped_newest, __ATOMIC_RELAXED);
+    p_stats->dropped_oldest = __atomic_load_n(&m_stats.dropped_oldest, __ATOMIC_RELAXED);
+    p_stats->timed_out = __atomic_load_n(&m_stats.timed_out, __ATOMIC_RELAXED);
+    p_stats->blocked = __atomic_load_n(&m_stats.blocked, __ATOMIC_RELAXED);
+    p_stats->rate_limited = __atomic_load_n(&m_stats.rate_limited, __ATOMIC_RELAXED);
+}
+
+
+void log_task_init(void)
+{
+    log_backend_init();
+
+    cycles_init();
+
+    log_ring_init(&m_log_ring, m_log_ring_buffer, sizeof(m_log_ring_buffer));
+    log_ring_init(&m_log_isr_ring, m_log_isr_ring_buffer,
+                  sizeof(m_log_isr_ring_buffer));
+
+    m_log_task_handle = osThreadNew(log_task, NULL, &m_log_task_attributes);
+    if (NULL == m_log_task_handle)
+    {
+        const char *msg = "ERROR - creating log task\n";
+        _output_message(msg);
+        return;
+    }
+
+    m_initialized = true;
+    LOG_INFO("Initialized\n");
+
+    _unit_test();
+
+#if LOG_BENCHMARK
+    log_bench_run();
+#endif
+}
+
+
+/**@brief   Internal function used to make room in the log ring by dropping
+ *          the oldest records.
+ *
+ * The records can only be dropped by the holder of the ring lock.  If the
+ * log task holds it, it's already making room.
+ *
+ * @param[in] size      The number of bytes to reserve.
+ *
+ * @return  The entry, NULL if there still isn't enough room.
+ */
+static void *_reserve_drop_oldest(size_t size)
+{
+    void *p_entry = NULL;
+
+    if (!log_ring_lock(&m_log_ring))
+    {
+        return NULL;
+    }
+
+    // A record that isn't committed yet can't be dropped, and blocks the
+    // records behind it.
+    while ((NULL == p_entry) && (NULL != log_ring_peek(&m_log_ring, NULL)))
+    {
+        log_ring_release(&m_log_ring);
+        __atomic_fetch_add(&m_stats.dropped_oldest, 1, __ATOMIC_RELAXED);
+
+        p_entry = log_ring_reserve(&m_log_ring, size);
+    }
+
+    log_ring_unlock(&m_log_ring);
+
+    return p_entry;
+}
+
+
+/**@brief   Internal function used to wait for the log task to make room in
+ *          the log ring.
+ *
+ * Only a thread other than the log task can wait, and only while the kernel
+ * is running and interrupts aren't masked.
+ *
+ * @param[in] size      The number of bytes to reserve.
+ *
+ * @return  The entry, NULL if the caller can't wait or there still isn't
+ *          enough room after the timeout.  The dropped record is counted.
+ */
+static void *_reserve_block(size_t size)
+{
+    uint32_t timeout = m_overflow_timeout_ms;
+
+    if (_in_isr() || (0 != __get_PRIMASK()) || (0 != __get_BASEPRI()) ||
+        (osKernelRunning != osKernelGetState()) ||
+        (osThreadGetId() == m_log_task_handle) ||
+        (0 == timeout))
+    {
+        __atomic_fetch_add(&m_stats.dropped_newest, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    __atomic_fetch_add(&m_stats.blocked, 1, __ATOMIC_RELAXED);
+
+    uint32_t ticks = (timeout * osKernelGetTickFreq() + 999) / 1000;
+    uint32_t start = osKernelGetTickCount();
+    void *p_entry;
+
+    do
+    {
+        // The log task may be waiting for a flag, or for the poll timeout
+        osThreadFlagsSet(m_log_task_handle, LOG_TASK_FLAG_RECORD);
+        osDelay(1);
+
+        p_entry = log_ring_reserve(&m_log_ring, size);
+    } while ((NULL == p_entry) && ((osKernelGetTickCount() - start) < ticks));
+
+    if (NULL == p_entry)
+    {
+        __atomic_fetch_add(&m_stats.timed_out, 1, __ATOMIC_RELAXED);
+    }
+
+    return p_entry;
+}
+
+
+/**@brief   Internal function used to reserve an entry in the log ring and
+ *          apply the overflow policy if it's full.
+ *
+ * @param[in] size      The number of bytes to reserve.
+ *
+ * @return  The entry, NULL if the record is dropped.
+ */
+static void *_reserve_entry(size_t size)
+{
+    void *p_entry = log_ring_reserve(&m_log_ring, size);
+
+    if (p_entry)
+    {
+        return p_entry;
+    }
+
+    switch (m_overflow_policy)
+    {
+        case LOG_OVERFLOW_DROP_OLDEST:
+            p_entry = _reserve_drop_oldest(size);
+            break;
+
+        case LOG_OVERFLOW_BLOCK:
+            // Counts the record itself
+            return _reserve_block(size);
+
+        default:
+            break;
+    }
+
+    if (NULL == p_entry)
+    {
+        __atomic_fetch_add(&m_stats.dropped_newest, 1, __ATOMIC_RELAXED);
+    }
+
+    return p_entry;
+}
+
+
+/**@brief   Internal function used to reserve a record in the log ring.
+ *
+ * If the ring is full the record is counted as dropped and reported later by
+ * the log task.
+ *
+ * @param[in] level     The log level of the record.
+ * @param[in] module    The value of LOG_MODULE_NAME of the record.
+ * @param[in] raw       True if a raw message, false otherwise.
+ * @param[in] file      The file containing the entry.
+ * @param[in] line      The line of the file that the entry starts at.
+ * @param[in] fmt       The format string, NULL if the record holds text.
+ * @param[in] size      The number of bytes of arguments or text.
+ *
+ * @return  The record, NULL if the ring is full.  The caller must fill in the
+ *          data and the length and then call _commit_record().
+ */
+static log_record_t *_reserve_record(
+    log_level_t level,
     const char *module,
     bool raw,
     const char *file,
     int line,
-    const void * const p_data,
-    size_t length,
-    uint16_t stride
+    const char *fmt,
+    size_t size
 )
 {
-    int i;
-    bool newline = true;
-    uint8_t *p = (uint8_t *) p_data;
-    char buffer[MAX_LOG_ENTRY];
-    char *output = buffer;
+    log_record_t *p_record;
 
-    if (p_data)
+#if LOG_TIMESTAMP
+    uint32_t timestamp = cycles_now();
+    log_stamped_record_t *p_stamped = _reserve_entry(
+        sizeof(log_stamped_record_t) + size);
+
+    if (NULL == p_stamped)
     {
-        for (i = 0; i < length; i++)
-        {
-            output += sprintf(output, "%02x ", p[i]);
-            newline = false;
+        return NULL;
+    }
 
-            if (((i + 1) % 4) == 0)
-            {
-                output += sprintf(output, " ");
-            }
+    p_stamped->timestamp = timestamp;
+    p_record = &p_stamped->record;
+#else
+    p_record = _reserve_entry(sizeof(log_record_t) + size);
+    if (NULL == p_record)
+    {
+        return NULL;
+    }
+#endif
 
-            if (((i + 1) % stride) == 0)
-            {
-                log_entry(level, module, raw, file, line, "%s\n", buffer);
-                newline = true;
-                output = buffer;
-            }
+    p_record->level = level;
+    p_record->flags = raw ? LOG_RECORD_RAW : 0;
+    p_record->module = module;
+    p_record->fmt = fmt;
+#if LOG_FILE_LINE
+    p_record->file = file;
+    p_record->line = line;
+#endif
+
+    return p_record;
+}
+
+
+/**@brief   Internal function used to pass a filled in record to the log task.
+ *
+ * @param[in] p_record  The record returned by _reserve_record().
+ */
+static void _commit_record(log_record_t *p_record)
+{
+    log_ring_commit(&m_log_ring, LOG_RECORD_ENTRY(p_record));
+
+    // Interrupts can't call the RTOS at every priority, the log task will
+    // find the record when it polls.
+    if (_in_isr())
+    {
+        return;
+    }
+
+    // Wake the log task if it's waiting for a record.  The fence pairs with
+    // the one in log_task().
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&m_log_task_waiting, false, __ATOMIC_RELAXED))
+    {
+        osThreadFlagsSet(m_log_task_handle, LOG_TASK_FLAG_RECORD);
+    }
+}
+
+
+/**@brief   Internal function used to add a record with its raw arguments to
+ *          the interrupt ring.
+ *
+ * @param[in] level     The log level of the record.
+ * @param[in] module    The value of LOG_MODULE_NAME of the record.
+ * @param[in] raw       True if a raw message, false otherwise.
+ * @param[in] fmt       The format string.
+ * @param[in] nargs     The number of arguments in ap.
+ * @param[in] ap        The arguments, each converted to a uintptr_t.
+ */
+static void _add_isr_record(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *fmt,
+    int nargs,
+    va_list ap
+)
+{
+    uint32_t timestamp = cycles_now();
+
+    if (nargs > LOG_DEFERRED_MAX_ARGS)
+    {
+        nargs = LOG_DEFERRED_MAX_ARGS;
+    }
+
+    log_isr_record_t *p_isr = log_ring_reserve(&m_log_isr_ring,
+        sizeof(log_isr_record_t) + nargs * sizeof(uintptr_t));
+    if (NULL == p_isr)
+    {
+        __atomic_fetch_add(&m_stats.dropped_newest, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    log_stamped_record_t *p_stamped = &p_isr->stamped;
+#if !LOG_TIMESTAMP
+    p_isr->position = __atomic_load_n(&m_log_ring.head, __ATOMIC_RELAXED);
+#endif
+
+    uintptr_t *p_args = LOG_RECORD_DATA(&p_stamped->record);
+
+    p_stamped->timestamp = timestamp;
+    p_stamped->record.level = level;
+    p_stamped->record.flags = raw ? LOG_RECORD_RAW : 0;
+    p_stamped->record.length = nargs;
+    p_stamped->record.module = module;
+    p_stamped->record.fmt = fmt;
+#if LOG_FILE_LINE
+    p_stamped->record.file = NULL;
+    p_stamped->record.line = 0;
+#endif
+
+    for (int i = 0; i < nargs; i++)
+    {
+        p_args[i] = va_arg(ap, uintptr_t);
+    }
+
+    log_ring_commit(&m_log_isr_ring, p_isr);
+}
+
+
+void log_isr_entry(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *fmt,
+    int nargs,
+    ...
+)
+{
+    va_list ap;
+
+    // The ring is empty until log_task_init() is called, so records added
+    // before then are dropped.
+    va_start(ap, nargs);
+    _add_isr_record(level, module, raw, fmt, nargs, ap);
+    va_end(ap);
+}
+
+
+#if LOG_RATE_LIMIT
+bool log_rate_check(uint32_t *p_state)
+{
+    // The HAL tick is read from any context and doesn't depend on the log
+    // task running
+    uint32_t now = HAL_GetTick() & LOG_RATE_TIME_MASK;
+    uint32_t state = __atomic_load_n(p_state, __ATOMIC_RELAXED);
+    uint32_t next;
+
+    do
+    {
+        uint32_t tokens = state >> LOG_RATE_TOKENS_SHIFT;
+        uint32_t filled = state & LOG_RATE_TIME_MASK;
+        uint32_t refill = ((now - filled) & LOG_RATE_TIME_MASK) / LOG_RATE_PERIOD_MS;
+
+        if (tokens + refill >= LOG_RATE_BURST)
+        {
+            tokens = LOG_RATE_BURST;
+            filled = now;
+        }
+        else
+        {
+            // Keep the time that doesn't add up to a whole message
+            tokens += refill;
+            filled = (filled + refill * LOG_RATE_PERIOD_MS) & LOG_RATE_TIME_MASK;
         }
 
-        if (!newline)
+        if (0 == tokens)
         {
-            log_entry(level, module, raw, file, line, "%s\n", buffer);
+            __atomic_fetch_add(&m_stats.rate_limited, 1, __ATOMIC_RELAXED);
+            return false;
         }
+
+        next = ((tokens - 1) << LOG_RATE_TOKENS_SHIFT) | filled;
+    } while (!__atomic_compare_exchange_n(p_state, &state, next, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return true;
+}
+#endif  // LOG_RATE_LIMIT
+
+
+/**@brief   Internal function used to add already formatted text to the log
+ *          ring.
+ *
+ * @param[in] level     The log level of the entry.
+ * @param[in] module    The value of LOG_MODULE_NAME of the entry.
+ * @param[in] raw       True if a raw message, false otherwise.
+ * @param[in] file      The file containing the entry.
+ * @param[in] line      The line of the file that the entry starts at.
+ * @param[in] text      The NULL terminated text to add.
+ */
+static void _queue_text(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *file,
+    int line,
+    const char *text
+)
+{
+    size_t length = strlen(text);
+    log_record_t *p_record = _reserve_record(level, module, raw, file, line,
+                                             NULL, length);
+
+    if (p_record)
+    {
+        p_record->length = length;
+        memcpy(LOG_RECORD_DATA(p_record), text, length);
+        _commit_record(p_record);
+    }
+}
+
+
+#if LOG_DEFERRED
+void log_deferred_entry(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *file,
+    int line,
+    const char *fmt,
+    int nargs,
+    ...
+)
+{
+    if (!m_initialized)
+    {
+        char *msg = "!! Log module not initialized\n";
+        _output_message(msg);
+        return;
+    }
+
+    va_list ap;
+
+    if (_in_isr())
+    {
+        // Use the same path as the LOG_ISR_* macros
+        va_start(ap, nargs);
+        _add_isr_record(level, module, raw, fmt, nargs, ap);
+        va_end(ap);
+        return;
+    }
+
+    if (nargs > LOG_DEFERRED_MAX_ARGS)
+    {
+        nargs = LOG_DEFERRED_MAX_ARGS;
+    }
+
+    log_record_t *p_record = _reserve_record(level, module, raw, file, line,
+                                             fmt, nargs * sizeof(uintptr_t));
+    if (NULL == p_record)
+    {
+        return;
+    }
+
+    uintptr_t *p_args = LOG_RECORD_DATA(p_record);
+
+    va_start(ap, nargs);
+    for (int i = 0; i < nargs; i++)
+    {
+        p_args[i] = va_arg(ap, uintptr_t);
+    }
+    va_end(ap);
+
+    p_record->length = nargs;
+    _commit_record(p_record);
+}
+#endif  // LOG_DEFERRED
+
+
+void log_entry(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *file,
+    int line,
+    const char *fmt,
+    ...
+)
+{
+    if (!m_initialized)
+    {
+        char *msg = "!! Log module not initialized\n";
+        _output_message(msg);
+        return;
     }
+
+    va_list ap;
+    char buffer[MAX_LOG_ENTRY];
+
+    va_start(ap, fmt);
+    int written = log_vsnprintf(buffer, sizeof(buffer), fmt, ap);
+    _mark_truncated(buffer, sizeof(buffer), written);
+    va_end(ap);
+
+    _queue_text(level, module, raw, file, line, buffer);
 }
 
 
@@ -468,49 +1972,63 @@ void log_hex_entry(
     uint16_t stride
 )
 {
+    if (!m_initialized)
+    {
+        char *msg = "!! Log module not initialized\n";
+        _output_message(msg);
+        return;
+    }
+
     if (NULL == p_data)
     {
         LOG_ERROR("NULL buffer\n");
         return;
     }
 
-    if (p_name)
+    if ((0 == stride) || (stride > MAX_HEX_STRIDE))
     {
-        log_entry(level, module, raw, file, line,
-            "%s (%d byte%s)\n",
-            p_name,
-            length,
-            length != 1 ? "s" : ""
-        );
+        stride = (0 == stride) ? DEFAULT_HEX_STRIDE : MAX_HEX_STRIDE;
     }
-    else
+
+    size_t head = (length > MAX_HEX_BYTES) ? START_HEX_BYTES : length;
+    size_t tail = (length > MAX_HEX_BYTES) ? END_HEX_BYTES : 0;
+    size_t name_length = p_name ? strlen(p_name) : 0;
+
+    if (name_length > MAX_HEX_NAME)
     {
-        log_entry(level, module, raw, file, line,
-            "(%d byte%s)\n",
-            length,
-            length != 1 ? "s" : ""
-        );
+        name_length = MAX_HEX_NAME;
     }
 
-    if (length > MAX_HEX_BYTES)
+    // Copy the bytes into a single record and let the log task format them.
+    // Only the first START_HEX_BYTES and the last END_HEX_BYTES of a large
+    // area are kept, otherwise we may run out of memory dumping larger
+    // buffers.
+    size_t size = sizeof(log_hex_t) + name_length + head + tail;
+    log_record_t *p_record = _reserve_record(level, module, raw, file, line,
+                                             NULL, size);
+    if (NULL == p_record)
     {
-        // print the first START_HEX_BYTES and the last END_HEX_BYTES and
-        // ignore the middle otherwise we may run out of memory dumping larger
-        // buffers.
-        _internal_dump_hex(level, module, raw, file, line,
-            p_data, START_HEX_BYTES, stride
-        );
+        return;
+    }
 
-        log_entry(level, module, raw, file, line, "...\n");
+    log_hex_t *p_hex = (log_hex_t *)LOG_RECORD_DATA(p_record);
+    uint8_t *p_bytes = (uint8_t *)(p_hex + 1);
 
-        _internal_dump_hex(level, module, raw, file, line,
-            p_data + length - END_HEX_BYTES, END_HEX_BYTES, stride
-        );
-    }
-    else
+    p_hex->total = length;
+    p_hex->head = head;
+    p_hex->stride = stride;
+    p_hex->name_length = name_length;
+    if (name_length)
     {
-        _internal_dump_hex(level, module, raw, file, line, p_data, length, stride);
+        memcpy(p_bytes, p_name, name_length);
+        p_bytes += name_length;
     }
+    memcpy(p_bytes, p_data, head);
+    memcpy(p_bytes + head, (const uint8_t *)p_data + length - tail, tail);
+
+    p_record->flags |= LOG_RECORD_HEX;
+    p_record->length = size;
+    _commit_record(p_record);
 }
 
 
@@ -13,6 +13,12 @@
   *    LOG_LEVEL_INFO messages or higher, set the value to 1.
   *
   *  - include log.h after setting the identifiers.
+  *
+  * When LOG_RUNTIME_LEVEL is enabled LOG_LEVEL is only the level the module
+  * starts with, see log_level_set().
+  *
+  * C++ files can include log.hpp instead, which checks the format strings of
+  * the LOG_* macros against their arguments at compile time.
   */
 
 #ifndef __X_LOG_H
@@ -60,12 +66,225 @@ typedef enum
 } log_level_t;
 
 
+/**@brief   What a LOG_* call does when the log ring is full.
+ *
+ * None of the policies write to the output device in the caller's context.
+ * Records from interrupts, and from callers that can't block, are always
+ * handled with LOG_OVERFLOW_DROP_NEWEST if the policy can't be applied.
+ */
+typedef enum
+{
+    LOG_OVERFLOW_DROP_NEWEST,   /**< Drop the new record. */
+    LOG_OVERFLOW_DROP_OLDEST,   /**< Drop the oldest records to make room,
+                                  *  unless the log task is reading them. */
+    LOG_OVERFLOW_BLOCK,         /**< Wait for the log task to make room, at
+                                  *  most the timeout of log_overflow_set(),
+                                  *  then drop the new record. */
+} log_overflow_t;
+
+/**@brief   The counters of the log module, see log_stats_get().
+ *
+ * The counters start at 0 at boot and wrap around.
+ */
+typedef struct
+{
+    uint32_t dropped_newest;    /**< New records dropped, ring full. */
+    uint32_t dropped_oldest;    /**< Old records dropped to make room. */
+    uint32_t timed_out;         /**< New records dropped after blocking. */
+    uint32_t blocked;           /**< Calls that waited for room. */
+    uint32_t rate_limited;      /**< Messages dropped by log_rate_check(). */
+} log_stats_t;
+
+/**@brief   The overflow policy used until log_overflow_set() is called.
+ */
+#ifndef LOG_OVERFLOW_POLICY
+#define LOG_OVERFLOW_POLICY     LOG_OVERFLOW_DROP_NEWEST
+#endif  // LOG_OVERFLOW_POLICY
+
+/**@brief   The longest time a LOG_* call waits for room with
+ *          LOG_OVERFLOW_BLOCK, in milliseconds, until log_overflow_set() is
+ *          called.
+ */
+#ifndef LOG_OVERFLOW_TIMEOUT_MS
+#define LOG_OVERFLOW_TIMEOUT_MS 10
+#endif  // LOG_OVERFLOW_TIMEOUT_MS
+
+/**@brief   Set to 1 to queue the format string and the raw argument words of
+ *          a LOG_* message instead of formatting it in the caller's context.
+ *
+ * The message is then formatted by the log task.  Deferred messages have a
+ * few restrictions:
+ *
+ *  - The format string and any %s arguments must remain valid until the log
+ *    task has processed the entry, i.e. string literals or static buffers.
+ *  - At most LOG_DEFERRED_MAX_ARGS arguments may follow the format string.
+ *  - Every argument is converted to a uintptr_t, so 64-bit integers and
+ *    floating point values can't be logged.
+ */
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED            0
+#endif  // LOG_DEFERRED
+
+/**@brief   The maximum number of arguments that can follow the format string
+ *          of a deferred log message.
+ */
+#define LOG_DEFERRED_MAX_ARGS   4
+
+/**@brief   Set to 1 to send string IDs and raw arguments to the host instead
+ *          of text.  Requires LOG_DEFERRED.
+ *
+ * The format strings and module names of the LOG_* macros are placed in the
+ * .log_str section, which is kept in the ELF file but not loaded on the
+ * target.  The log task writes binary frames to the output device and
+ * tools/log_decoder.py formats them on the host using the ELF file.
+ */
+#ifndef LOG_DICTIONARY
+#define LOG_DICTIONARY          0
+#endif  // LOG_DICTIONARY
+
+#if LOG_DICTIONARY && !LOG_DEFERRED
+#error "LOG_DICTIONARY requires LOG_DEFERRED"
+#endif
+
+/**@brief   Set to 1 to add a timestamp to every log record.
+ *
+ * The DWT cycle counter is read when the record is added and the log task
+ * prints it as seconds and microseconds since boot.  Records from the
+ * LOG_ISR_* macros always have a timestamp.  When set to 0 the other records
+ * don't store or print a timestamp.
+ */
+#ifndef LOG_TIMESTAMP
+#define LOG_TIMESTAMP           0
+#endif  // LOG_TIMESTAMP
+
+/**@brief   Set to 1 to store the file and line of a LOG_* message in the
+ *          record and print them after the module name.
+ *
+ * Records from the LOG_ISR_* macros don't have a file and line.
+ */
+#ifndef LOG_FILE_LINE
+#define LOG_FILE_LINE           0
+#endif  // LOG_FILE_LINE
+
+/**@brief   Set to 1 to let the level of each module be changed at run time.
+ *
+ * Every file that includes log.h adds an entry holding LOG_MODULE_NAME and a
+ * level byte to a table in RAM.  The level starts at LOG_LEVEL and can be
+ * changed with log_level_set() or with the "log" command on the RTT down
+ * channel.  Testing a message against the level of its module is a single
+ * load and compare, there is no function call unless the message is logged.
+ */
+#ifndef LOG_RUNTIME_LEVEL
+#define LOG_RUNTIME_LEVEL       1
+#endif  // LOG_RUNTIME_LEVEL
+
+/**@brief   The lowest level of the messages that are compiled in.
+ *
+ * Messages below this level are removed by the compiler, whatever the run
+ * time level of the module is.  It can be set per file, like LOG_LEVEL.
+ */
+#ifndef LOG_LEVEL_MIN
+#if LOG_RUNTIME_LEVEL
+#define LOG_LEVEL_MIN           LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL_MIN           LOG_LEVEL
+#endif  // LOG_RUNTIME_LEVEL
+#endif  // LOG_LEVEL_MIN
+
+/**@brief   Set to 1 to limit the rate of the messages of every LOG_* call.
+ *
+ * Every call has a token bucket that holds up to LOG_RATE_BURST messages and
+ * gets one more every LOG_RATE_PERIOD_MS of HAL_GetTick().  A message logged
+ * while the bucket is empty is dropped and counted, the log task reports the
+ * count with the records that didn't fit in the ring.  The bucket is only
+ * checked once the message passes the level test.  Raw messages, such as
+ * tables and the output of the commands, are never limited.
+ *
+ * The values must be the same for the whole build.
+ */
+#ifndef LOG_RATE_LIMIT
+#define LOG_RATE_LIMIT          0
+#endif  // LOG_RATE_LIMIT
+
+/**@brief   The number of messages a LOG_* call can log back to back, at most
+ *          255.
+ */
+#ifndef LOG_RATE_BURST
+#define LOG_RATE_BURST          20
+#endif  // LOG_RATE_BURST
+
+/**@brief   The time it takes a LOG_* call to get back one message of its
+ *          burst, in milliseconds.
+ */
+#ifndef LOG_RATE_PERIOD_MS
+#define LOG_RATE_PERIOD_MS      100
+#endif  // LOG_RATE_PERIOD_MS
+
+#if LOG_RATE_BURST > 255
+#error "LOG_RATE_BURST must be 255 or less"
+#endif
+
+/**@brief   The section that holds the strings of the LOG_* macros in
+ *          dictionary mode.
+ */
+#define LOG_STRING_SECTION      ".log_str"
+
+/**@brief   The section that holds the log_module_t entries of the modules.
+ *
+ * The linker script places it in .data, between __log_modules_start and
+ * __log_modules_end.
+ */
+#define LOG_MODULE_SECTION      ".log_modules"
+
 #define __STRINGIFY__(value)    #value
 
 /**@brief   Converts a macro into a character constant.
  */
 #define STRINGIFY(value)        __STRINGIFY__(value)
 
+/**@brief   The run time level of a module.
+ */
+typedef struct
+{
+    const char *name;           /**< The value of LOG_MODULE_NAME. */
+    volatile uint8_t level;     /**< Messages below this level are dropped. */
+} log_module_t;
+
+#if LOG_RUNTIME_LEVEL && defined(LOG_MODULE_NAME)
+/**@brief   The entry of the file including log.h in the module table.
+ *
+ * Files with the same LOG_MODULE_NAME each have an entry, log_level_set()
+ * changes all of them.
+ */
+static log_module_t log_module_entry_
+    __attribute__((section(LOG_MODULE_SECTION), used)) =
+{
+    STRINGIFY(LOG_MODULE_NAME),
+    LOG_LEVEL,
+};
+#endif
+
+// Internal macros to declare the token bucket of a LOG_* call and to take a
+// message from it.  The bucket starts full, see log_rate_check().
+#if LOG_RATE_LIMIT
+#define LOG_RATE_STATE(NAME)                                                    \
+    static uint32_t NAME = (uint32_t)LOG_RATE_BURST << 24
+#define LOG_RATE_CHECK(NAME)    log_rate_check(&(NAME))
+#else
+#define LOG_RATE_STATE(NAME)    do {} while (0)
+#define LOG_RATE_CHECK(NAME)    true
+#endif  // LOG_RATE_LIMIT
+
+// Internal macro to test if a message of a level should be logged
+#if LOG_RUNTIME_LEVEL
+#define LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL)                                \
+    (((LOG_LEVEL_MIN) <= (TRIGGER_LEVEL)) &&                                    \
+     (log_module_entry_.level <= (TRIGGER_LEVEL)))
+#else
+#define LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL)                                \
+    ((MODULE_LEVEL) <= (TRIGGER_LEVEL))
+#endif  // LOG_RUNTIME_LEVEL
+
 /**@brief   Log a message if the module has LOG_LEVEL set to LOG_LEVEL_DEBUG or
  *          lower.
  */
@@ -135,12 +354,145 @@ typedef enum
 #define LOG_RAW_CRITICAL(...)                                                   \
     LOG_INTERNAL(LOG_LEVEL, LOG_LEVEL_CRITICAL, STRINGIFY(LOG_MODULE_NAME), true, __VA_ARGS__)
 
+/**@brief   Log a message from an interrupt if the module has LOG_LEVEL set to
+ *          LOG_LEVEL_DEBUG or lower.
+ *
+ * The LOG_ISR_* macros never format the message in the caller's context.
+ * They store a cycle counter timestamp, the format string and the raw
+ * argument words in a lock-free ring that is only used by interrupts, and the
+ * log task formats the message later.  They don't call the RTOS, so they can
+ * be used at any interrupt priority.  The restrictions of LOG_DEFERRED apply
+ * to their arguments, even if LOG_DEFERRED isn't enabled.
+ */
+#define LOG_ISR_DEBUG(...)                                                      \
+    LOG_ISR_INTERNAL(LOG_LEVEL, LOG_LEVEL_DEBUG, STRINGIFY(LOG_MODULE_NAME), false, __VA_ARGS__)
+
+/**@brief   Log a message from an interrupt if the module has LOG_LEVEL set to
+ *          LOG_LEVEL_INFO or lower.
+ */
+#define LOG_ISR_INFO(...)                                                       \
+    LOG_ISR_INTERNAL(LOG_LEVEL, LOG_LEVEL_INFO, STRINGIFY(LOG_MODULE_NAME), false, __VA_ARGS__)
+
+/**@brief   Log a message from an interrupt if the module has LOG_LEVEL set to
+ *          LOG_LEVEL_WARNING or lower.
+ */
+#define LOG_ISR_WARNING(...)                                                    \
+    LOG_ISR_INTERNAL(LOG_LEVEL, LOG_LEVEL_WARNING, STRINGIFY(LOG_MODULE_NAME), false, __VA_ARGS__)
+
+/**@brief   Log a message from an interrupt if the module has LOG_LEVEL set to
+ *          LOG_LEVEL_ERROR or lower.
+ */
+#define LOG_ISR_ERROR(...)                                                      \
+    LOG_ISR_INTERNAL(LOG_LEVEL, LOG_LEVEL_ERROR, STRINGIFY(LOG_MODULE_NAME), false, __VA_ARGS__)
+
+/**@brief   Log a message from an interrupt if the module has LOG_LEVEL set to
+ *          LOG_LEVEL_CRITICAL or lower.
+ */
+#define LOG_ISR_CRITICAL(...)                                                   \
+    LOG_ISR_INTERNAL(LOG_LEVEL, LOG_LEVEL_CRITICAL, STRINGIFY(LOG_MODULE_NAME), false, __VA_ARGS__)
+
+// Internal macros to split the format string from the arguments of a
+// message, count the arguments and convert each of them to a uintptr_t.
+#define LOG_CONCAT(a, b)        LOG_CONCAT_(a, b)
+#define LOG_CONCAT_(a, b)       a##b
+
+#define LOG_ARGS_FORMAT(...)    LOG_ARGS_FORMAT_(__VA_ARGS__, ~)
+#define LOG_ARGS_FORMAT_(fmt, ...)  fmt
+
+#define LOG_ARGS_COUNT(...)     LOG_ARGS_COUNT_(__VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define LOG_ARGS_COUNT_(fmt, _1, _2, _3, _4, _5, _6, _7, N, ...)   N
+
+#ifndef LOG_ARG
+#define LOG_ARG(arg)            ((uintptr_t)(arg))
+#endif  // LOG_ARG
+
+#define LOG_ARGS_PACK_0(fmt)
+#define LOG_ARGS_PACK_1(fmt, a)             , LOG_ARG(a)
+#define LOG_ARGS_PACK_2(fmt, a, b)          , LOG_ARG(a), LOG_ARG(b)
+#define LOG_ARGS_PACK_3(fmt, a, b, c)       , LOG_ARG(a), LOG_ARG(b), LOG_ARG(c)
+#define LOG_ARGS_PACK_4(fmt, a, b, c, d)    , LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d)
+
+// Expands to nothing if there are no arguments, otherwise to a leading comma
+// followed by the converted arguments.  More than LOG_DEFERRED_MAX_ARGS
+// arguments results in a compile error.
+#define LOG_ARGS_PACK(...)                                                      \
+    LOG_CONCAT(LOG_ARGS_PACK_, LOG_ARGS_COUNT(__VA_ARGS__))(__VA_ARGS__)
+
+// Internal macro to check the format string of a message against its
+// arguments.  WORDS is true if the arguments are stored as uintptr_t words.
+// log.hpp replaces it for C++.
+#ifndef LOG_FORMAT_CHECK
+#define LOG_FORMAT_CHECK(WORDS, ...)    do {} while (0)
+#endif  // LOG_FORMAT_CHECK
+
+// Internal macro to declare a pointer to a string literal.  In dictionary
+// mode the string is moved to LOG_STRING_SECTION.
+#if LOG_DICTIONARY
+#define LOG_STRING(NAME, STR)                                                   \
+    static const char NAME[] __attribute__((section(LOG_STRING_SECTION))) = STR
+#else
+#define LOG_STRING(NAME, STR)                                                   \
+    const char * const NAME = STR
+#endif  // LOG_DICTIONARY
+
+// Internal macro to declare a pointer to the file of a message.  The file is
+// only kept if it will be printed.
+#if LOG_FILE_LINE
+#define LOG_FILE_STRING(NAME)   LOG_STRING(NAME, __FILE__)
+#else
+#define LOG_FILE_STRING(NAME)   const char * const NAME = NULL
+#endif  // LOG_FILE_LINE
+
 // Internal macro to test if logging should occur
+#if LOG_DEFERRED
 #define LOG_INTERNAL(MODULE_LEVEL, TRIGGER_LEVEL, MODULE_NAME, RAW, ...)        \
     do {                                                                        \
-        if ((MODULE_LEVEL) <= (TRIGGER_LEVEL))                                  \
+        LOG_FORMAT_CHECK(true, __VA_ARGS__);                                    \
+        if (LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL))                           \
+        {                                                                       \
+            LOG_RATE_STATE(log_rate_);                                          \
+            if ((RAW) || LOG_RATE_CHECK(log_rate_))                             \
+            {                                                                   \
+                LOG_STRING(log_module_, MODULE_NAME);                           \
+                LOG_STRING(log_fmt_, LOG_ARGS_FORMAT(__VA_ARGS__));             \
+                LOG_FILE_STRING(log_file_);                                     \
+                log_deferred_entry((TRIGGER_LEVEL), log_module_, (RAW), log_file_, __LINE__, \
+                    log_fmt_,                                                   \
+                    LOG_ARGS_COUNT(__VA_ARGS__)                                 \
+                    LOG_ARGS_PACK(__VA_ARGS__));                                \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+#else
+#define LOG_INTERNAL(MODULE_LEVEL, TRIGGER_LEVEL, MODULE_NAME, RAW, ...)        \
+    do {                                                                        \
+        LOG_FORMAT_CHECK(false, __VA_ARGS__);                                   \
+        if (LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL))                           \
+        {                                                                       \
+            LOG_RATE_STATE(log_rate_);                                          \
+            if ((RAW) || LOG_RATE_CHECK(log_rate_))                             \
+            {                                                                   \
+                log_entry((TRIGGER_LEVEL), (MODULE_NAME), (RAW), __FILE__, __LINE__, __VA_ARGS__); \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+#endif  // LOG_DEFERRED
+
+// Internal macro to test if logging from an interrupt should occur
+#define LOG_ISR_INTERNAL(MODULE_LEVEL, TRIGGER_LEVEL, MODULE_NAME, RAW, ...)    \
+    do {                                                                        \
+        LOG_FORMAT_CHECK(true, __VA_ARGS__);                                    \
+        if (LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL))                           \
         {                                                                       \
-            log_entry((TRIGGER_LEVEL), (MODULE_NAME), (RAW), __FILE__, __LINE__, __VA_ARGS__); \
+            LOG_RATE_STATE(log_rate_);                                          \
+            if ((RAW) || LOG_RATE_CHECK(log_rate_))                             \
+            {                                                                   \
+                LOG_STRING(log_module_, MODULE_NAME);                           \
+                LOG_STRING(log_fmt_, LOG_ARGS_FORMAT(__VA_ARGS__));             \
+                log_isr_entry((TRIGGER_LEVEL), log_module_, (RAW), log_fmt_,    \
+                    LOG_ARGS_COUNT(__VA_ARGS__)                                 \
+                    LOG_ARGS_PACK(__VA_ARGS__));                                \
+            }                                                                   \
         }                                                                       \
     } while (0)
 
@@ -216,19 +568,25 @@ typedef enum
 // Internal macro to test if logging should occur
 #define LOG_HEX_INTERNAL(MODULE_LEVEL, TRIGGER_LEVEL, MODULE_NAME, RAW, DESCRIPT, DATA, LENGTH, STRIDE) \
     do {                                                                        \
-        if ((MODULE_LEVEL) <= (TRIGGER_LEVEL))                                  \
+        if (LOG_ENABLED(MODULE_LEVEL, TRIGGER_LEVEL))                           \
         {                                                                       \
-            log_hex_entry(                                                      \
-                (TRIGGER_LEVEL),                                                \
-                (MODULE_NAME),                                                  \
-                (RAW),                                                          \
-                __FILE__,                                                       \
-                __LINE__,                                                       \
-                (DESCRIPT),                                                     \
-                (DATA),                                                         \
-                (LENGTH),                                                       \
-                (STRIDE)                                                        \
-            );                                                                  \
+            LOG_RATE_STATE(log_rate_);                                          \
+            if ((RAW) || LOG_RATE_CHECK(log_rate_))                             \
+            {                                                                   \
+                LOG_STRING(log_module_, MODULE_NAME);                           \
+                LOG_FILE_STRING(log_file_);                                     \
+                log_hex_entry(                                                  \
+                    (TRIGGER_LEVEL),                                            \
+                    log_module_,                                                \
+                    (RAW),                                                      \
+                    log_file_,                                                  \
+                    __LINE__,                                                   \
+                    (DESCRIPT),                                                 \
+                    (DATA),                                                     \
+                    (LENGTH),                                                   \
+                    (STRIDE)                                                    \
+                );                                                              \
+            }                                                                   \
         }                                                                       \
     } while (0)
 
@@ -259,14 +617,71 @@ void log_entry(
     ...
 );
 
+#if LOG_DEFERRED
+/**@brief   Add an unformatted entry to the log queue.
+ *
+ * NOTE: Users of the module should use the macro's and not call this function directly.
+ *
+ * The format string and the arguments are stored in the queue and the message
+ * is formatted by the log task.  See LOG_DEFERRED for the restrictions.
+ *
+ * @param[in] level     The log level of the entry.
+ * @param[in] module    The value of LOG_MODULE_NAME of the entry.
+ * @param[in] file      The file containing the entry.
+ * @param[in] line      The line of the file that the entry starts at.
+ * @param[in] fmt       A printf format string to format the remaining arguments.
+ * @param[in] nargs     The number of arguments that follow, at most
+ *                      LOG_DEFERRED_MAX_ARGS.
+ * @param[in] ...       The arguments, each converted to a uintptr_t.
+ */
+void log_deferred_entry(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *file,
+    int line,
+    const char *fmt,
+    int nargs,
+    ...
+);
+#endif  // LOG_DEFERRED
+
+/**@brief   Add an entry from an interrupt to the log.
+ *
+ * NOTE: Users of the module should use the LOG_ISR_* macro's and not call this
+ *       function directly.
+ *
+ * The format string and the arguments are stored in the interrupt ring with
+ * a timestamp and the message is formatted by the log task.  If the ring is
+ * full the entry is dropped and counted.
+ *
+ * @param[in] level     The log level of the entry.
+ * @param[in] module    The value of LOG_MODULE_NAME of the entry.
+ * @param[in] raw       True if a raw message, false otherwise.
+ * @param[in] fmt       A printf format string to format the remaining arguments.
+ * @param[in] nargs     The number of arguments that follow, at most
+ *                      LOG_DEFERRED_MAX_ARGS.
+ * @param[in] ...       The arguments, each converted to a uintptr_t.
+ */
+void log_isr_entry(
+    log_level_t level,
+    const char *module,
+    bool raw,
+    const char *fmt,
+    int nargs,
+    ...
+);
+
 /**@brief   Add a hex dump of a memory area to the log queue.
  *
  * NOTE: Users of the module should use the macro's and not call this function directly.
  *
- * This function will limit the number of bytes output to MAX_HEX_BYTES.  If
- * the requested area is larger than MAX_HEX_BYTES, the first START_HEX_BYTES
- * and the last END_HEX_BYTES will be output.  This is intended to prevent the
- * log queue from filling up from a large hex dump.
+ * The bytes are copied into a single record and formatted by the log task,
+ * or by tools/log_decoder.py in dictionary mode.  This function will limit
+ * the number of bytes output to MAX_HEX_BYTES.  If the requested area is
+ * larger than MAX_HEX_BYTES, the first START_HEX_BYTES and the last
+ * END_HEX_BYTES will be output.  This is intended to prevent the log queue
+ * from filling up from a large hex dump.
  *
  * @param[in] level     The log level of the entry.
  * @param[in] module    The value of LOG_MODULE_NAME of the entry.
@@ -289,6 +704,71 @@ void log_hex_entry(
     uint16_t stride
 );
 
+/**@brief   Take a message from the token bucket of a LOG_* call.
+ *
+ * NOTE: Users of the module should use the macro's and not call this function directly.
+ *
+ * This function doesn't call the RTOS, so it can be used from any context.
+ *
+ * @param[in,out] p_state   The bucket, the number of messages it holds in
+ *                          the upper 8 bits and the time it was last filled
+ *                          in the lower 24 bits.
+ *
+ * @return  True if the message can be logged, false if it's rate limited.
+ */
+bool log_rate_check(uint32_t *p_state);
+
+/**@brief   Set what a LOG_* call does when the log ring is full.
+ *
+ * @param[in] policy        The overflow policy.
+ * @param[in] timeout_ms    The longest time to wait for room with
+ *                          LOG_OVERFLOW_BLOCK, in milliseconds.
+ */
+void log_overflow_set(log_overflow_t policy, uint32_t timeout_ms);
+
+/**@brief   Get the counters of the log module.
+ *
+ * @param[out] p_stats  Set to the current value of the counters.
+ */
+void log_stats_get(log_stats_t *p_stats);
+
+/**@brief   Set the run time level of a module.
+ *
+ * Only has an effect if LOG_RUNTIME_LEVEL is enabled.  Messages below
+ * LOG_LEVEL_MIN of their file can't be enabled.
+ *
+ * @param[in] module    The value of LOG_MODULE_NAME of the module, "*" or
+ *                      NULL for every module.
+ * @param[in] level     Messages below this level are dropped.
+ *
+ * @return  True if at least one module was changed, false otherwise.
+ */
+bool log_level_set(const char *module, log_level_t level);
+
+/**@brief   Get the run time level of a module.
+ *
+ * @param[in] module    The value of LOG_MODULE_NAME of the module.
+ *
+ * @return  The level of the module, LOG_LEVEL_End if it isn't known.
+ */
+log_level_t log_level_get(const char *module);
+
+/**@brief   Run a log level command.
+ *
+ * The log task runs the lines received on the RTT down channel with this
+ * function.  The commands are:
+ *
+ *  - "log list" logs the level of every module.
+ *  - "log stats" logs the counters of log_stats_get().
+ *  - "log <module> <level>" sets the level of a module, "*" for every module.
+ *    The level is a name, e.g. "debug", or a number.
+ *
+ * @param[in] command   The command line, without the line ending.
+ *
+ * @return  True if the command was run, false if it isn't valid.
+ */
+bool log_level_command(const char *command);
+
 /**
  * @brief   Function to dump the current contents of the log to the ouput.
  *
@@ -0,0 +1,298 @@
+/**
+  ******************************************************************************
+  * File Name          : log.hpp
+  * Description        : This file provides the C++ front end of the logging
+  *                      interface.
+  *
+  * A C++ file includes this file instead of log.h, after setting
+  * LOG_MODULE_NAME and LOG_LEVEL the same way.  The LOG_* macros are the
+  * ones of log.h and log to the same modules, levels and ring as the C
+  * files, but every call also gets a static_assert that parses the format
+  * string at compile time and checks it against the arguments:
+  *
+  *  - the number of arguments, including the ones of a '*' width or
+  *    precision, must match the conversions.
+  *
+  *  - %d, %i, %u, %o, %x, %X and %c take an integer or an enumeration, %s a
+  *    char pointer, %p any pointer and the floating point conversions a
+  *    float or a double.  Integers are checked by size against the length
+  *    modifier rather than by exact type, since the size is what decides how
+  *    the argument is read.
+  *
+  *  - when the arguments are stored as words, by LOG_DEFERRED and the
+  *    LOG_ISR_* macros, there can be at most LOG_DEFERRED_MAX_ARGS of them
+  *    and each must fit in a uintptr_t, so %f and %ll are rejected.
+  *
+  * The arguments are then converted to their words by logging::pack(), which
+  * only accepts the types above.  The number of words is known at compile
+  * time, nothing is parsed at run time until the log task formats the
+  * message.
+  *
+  * The checks use C++14 constexpr functions, the format string can't be a
+  * template argument before C++20.
+  */
+
+#ifndef __X_LOG_HPP
+#define __X_LOG_HPP
+
+#ifdef __X_LOG_H
+#error "log.hpp must be included instead of log.h, not after it"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Replace the hooks of log.h, the functions they call are defined below
+#define LOG_FORMAT_CHECK(WORDS, ...)                                            \
+    static_assert(::logging::check_format((WORDS),                             \
+                      decltype(::logging::types_of(__VA_ARGS__)){},             \
+                      LOG_ARGS_FORMAT(__VA_ARGS__)),                            \
+                  "The format string doesn't match the arguments")
+#define LOG_ARG(arg)            ::logging::pack(arg)
+
+#include "log.h"
+
+namespace logging
+{
+
+/**@brief   The kinds of arguments of a format string.
+ */
+enum class arg_kind : uint8_t
+{
+    none,                       /**< Not a valid argument. */
+    integer,                    /**< An integer, bool or enumeration. */
+    string,                     /**< A pointer to char. */
+    pointer,                    /**< Any other pointer. */
+    floating,                   /**< A float or a double. */
+};
+
+/**@brief   The kind and size of an argument.
+ */
+struct arg_info
+{
+    arg_kind kind;
+    size_t size;
+};
+
+/**@brief   An empty type that holds the types of the arguments of a call.
+ */
+template <typename... T>
+struct type_list
+{
+};
+
+/**@brief   Get the types of the arguments of a call, only used in decltype.
+ *
+ * The arguments are taken by value, so arrays and functions decay to
+ * pointers and the qualifiers are removed.
+ */
+template <typename... T>
+type_list<T...> types_of(const char *fmt, T... args);
+
+/**@brief   Test if a type is a pointer to one of the char types.
+ */
+template <typename T>
+constexpr bool is_string()
+{
+    using pointee = typename std::remove_cv<typename std::remove_pointer<T>::type>::type;
+
+    return std::is_pointer<T>::value &&
+           (std::is_same<pointee, char>::value ||
+            std::is_same<pointee, signed char>::value ||
+            std::is_same<pointee, unsigned char>::value);
+}
+
+/**@brief   Get the kind and size of an argument type.
+ */
+template <typename T>
+constexpr arg_info info_of()
+{
+    return (std::is_integral<T>::value || std::is_enum<T>::value) ?
+               arg_info{ arg_kind::integer, sizeof(T) } :
+           is_string<T>() ?
+               arg_info{ arg_kind::string, sizeof(T) } :
+           (std::is_pointer<T>::value || std::is_null_pointer<T>::value) ?
+               arg_info{ arg_kind::pointer, sizeof(T) } :
+           std::is_floating_point<T>::value ?
+               arg_info{ arg_kind::floating, sizeof(double) } :
+               arg_info{ arg_kind::none, sizeof(T) };
+}
+
+/**@brief   Test if an argument matches an integer conversion.
+ *
+ * @param[in] length    The length modifier, 'H' for hh and 'L' for ll.
+ * @param[in] arg       The argument.
+ */
+constexpr bool integer_matches(char length, const arg_info &arg)
+{
+    return (arg_kind::integer == arg.kind) &&
+           (('l' == length) ? (sizeof(long) == arg.size) :
+            ('L' == length) ? (sizeof(long long) == arg.size) :
+            ('j' == length) ? (sizeof(intmax_t) == arg.size) :
+            ('z' == length) ? (sizeof(size_t) == arg.size) :
+            ('t' == length) ? (sizeof(ptrdiff_t) == arg.size) :
+            (arg.size <= sizeof(int)));
+}
+
+/**@brief   Test if an argument matches a conversion.
+ *
+ * @param[in] conversion    The conversion character.
+ * @param[in] length        The length modifier, 'H' for hh and 'L' for ll.
+ * @param[in] arg           The argument.
+ * @param[in] words         True if the argument is stored as a word.
+ */
+constexpr bool arg_matches(char conversion, char length, const arg_info &arg, bool words)
+{
+    return (words && ((arg.size > sizeof(uintptr_t)) ||
+                      (arg_kind::floating == arg.kind))) ? false :
+           (('d' == conversion) || ('i' == conversion) ||
+            ('u' == conversion) || ('o' == conversion) ||
+            ('x' == conversion) || ('X' == conversion)) ?
+               integer_matches(length, arg) :
+           ('c' == conversion) ?
+               (0 == length) && integer_matches(0, arg) :
+           ('s' == conversion) ?
+               (0 == length) && (arg_kind::string == arg.kind) :
+           ('p' == conversion) ?
+               (0 == length) && ((arg_kind::pointer == arg.kind) ||
+                                 (arg_kind::string == arg.kind)) :
+           (('f' == conversion) || ('F' == conversion) ||
+            ('e' == conversion) || ('E' == conversion) ||
+            ('g' == conversion) || ('G' == conversion) ||
+            ('a' == conversion) || ('A' == conversion)) ?
+               ((0 == length) || ('l' == length)) &&
+               (arg_kind::floating == arg.kind) :
+           false;
+}
+
+/**@brief   Check a format string against the kinds of its arguments.
+ *
+ * @param[in] fmt       The format string.
+ * @param[in] args      The arguments.
+ * @param[in] count     The number of arguments.
+ * @param[in] words     True if the arguments are stored as words.
+ *
+ * @return  True if the arguments match the format string.
+ */
+constexpr bool check_args(const char *fmt, const arg_info *args, size_t count, bool words)
+{
+    size_t index = 0;
+
+    while (*fmt)
+    {
+        if ('%' != *fmt++)
+        {
+            continue;
+        }
+
+        if ('%' == *fmt)
+        {
+            fmt++;
+            continue;
+        }
+
+        while (('-' == *fmt) || ('+' == *fmt) || (' ' == *fmt) ||
+               ('#' == *fmt) || ('0' == *fmt))
+        {
+            fmt++;
+        }
+
+        // The width and the precision may be int arguments
+        for (int field = 0; field < 2; field++)
+        {
+            if ((1 == field) && ('.' != *fmt++))
+            {
+                fmt--;
+                break;
+            }
+
+            if ('*' == *fmt)
+            {
+                if ((index >= count) || !integer_matches(0, args[index++]))
+                {
+                    return false;
+                }
+                fmt++;
+            }
+
+            while (('0' <= *fmt) && ('9' >= *fmt))
+            {
+                fmt++;
+            }
+        }
+
+        char length = 0;
+        if (('h' == *fmt) || ('l' == *fmt) || ('j' == *fmt) ||
+            ('z' == *fmt) || ('t' == *fmt))
+        {
+            length = *fmt++;
+            if ((('h' == length) || ('l' == length)) && (length == *fmt))
+            {
+                length = ('h' == length) ? 'H' : 'L';
+                fmt++;
+            }
+        }
+
+        if ((index >= count) || !arg_matches(*fmt, length, args[index++], words))
+        {
+            return false;
+        }
+
+        if (*fmt)
+        {
+            fmt++;
+        }
+    }
+
+    return (index == count) && (!words || (count <= LOG_DEFERRED_MAX_ARGS));
+}
+
+/**@brief   Check a format string against the types of its arguments.
+ *
+ * @param[in] words     True if the arguments are stored as words.
+ * @param[in] types     The types of the arguments, see types_of().
+ * @param[in] fmt       The format string.
+ *
+ * @return  True if the arguments match the format string.
+ */
+template <typename... T>
+constexpr bool check_format(bool words, type_list<T...> types, const char *fmt)
+{
+    // The last entry keeps the array from being empty
+    const arg_info args[] = { info_of<T>()..., arg_info{ arg_kind::none, 0 } };
+
+    return check_args(fmt, args, sizeof...(T), words);
+}
+
+/**@brief   Convert an integer or an enumeration argument to its word.
+ */
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value ||
+                                  std::is_enum<T>::value, int>::type = 0>
+inline uintptr_t pack(T value)
+{
+    static_assert(sizeof(T) <= sizeof(uintptr_t), "The argument doesn't fit in a word");
+    return static_cast<uintptr_t>(value);
+}
+
+/**@brief   Convert a pointer argument to its word.
+ */
+template <typename T>
+inline uintptr_t pack(T *value)
+{
+    return reinterpret_cast<uintptr_t>(value);
+}
+
+/**@brief   Convert a nullptr argument to its word.
+ */
+inline uintptr_t pack(std::nullptr_t)
+{
+    return 0;
+}
+
+}  // namespace logging
+
+#endif  // __X_LOG_HPP
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
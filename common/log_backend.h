@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * File Name          : log_backend.h
+  * Description        : This file provides the API between the log module and
+  *                      the device the log messages are written to.
+  *
+  * Exactly one backend is compiled in, selected by the LOG_BACKEND_*
+  * identifiers below.  Only the log module should use this API.
+  *
+  * A backend may let the log task copy a block directly into its output
+  * buffer: log_backend_reserve() returns a contiguous span of the buffer and
+  * log_backend_commit() hands the bytes written to it to the device.  Nothing
+  * else can write to the backend between the two calls, which may mask the
+  * interrupts, so the span must be committed as soon as possible, even if
+  * nothing was written to it.  Nothing but a copy should be done in between.
+  *
+  * The log task doesn't format its lines straight into the span, on purpose.
+  * Formatting a line takes far longer than copying it, and with the RTT
+  * backend the interrupts up to SEGGER_RTT_MAX_INTERRUPT_PRIORITY would be
+  * masked for all of it.  A line is formatted into a buffer on the stack of
+  * the log task and written with one log_backend_write(), which takes the
+  * lock once per line.  The span is used for blocks that are already
+  * formatted, such as the log replayed by log_persist_replay().
+  */
+
+#ifndef __X_LOG_BACKEND_H
+#define __X_LOG_BACKEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**@brief   Set to 1 to use the SEGGER RTT output channel for log messages.
+ *          Set to 0 to use ST-LINK UART.
+ *
+ * The host build, BUILD_UT, always writes to the standard output.
+ */
+#ifndef USE_RTT
+#define USE_RTT                 1
+#endif
+
+#if defined(BUILD_UT)
+    #define LOG_BACKEND_STDIO   1
+#elif USE_RTT
+    #define LOG_BACKEND_RTT     1
+#else
+    #define LOG_BACKEND_UART    1
+#endif
+
+
+/**@brief   Initialize the backend.
+ *
+ * Called by log_task_init() before any other function of the backend.
+ */
+void log_backend_init(void);
+
+/**@brief   Write bytes to the backend.
+ *
+ * This function can be called from any context.  If the backend doesn't have
+ * room for all of the bytes they may be dropped.
+ *
+ * @param[in]   str     The bytes to write.
+ * @param[in]   len     The number of bytes to write.
+ */
+void log_backend_write(const char *str, size_t len);
+
+/**@brief   Reserve a contiguous span of the backend output buffer.
+ *
+ * If a span is returned, log_backend_commit() must be called before any
+ * other function of the backend.
+ *
+ * The state of the lock is kept by the caller, like SEGGER_RTT_LOCK() does,
+ * so that an interrupt that reserves a span while a task holds one restores
+ * its own state.
+ *
+ * @param[out]  p_size  Set to the number of bytes in the span.
+ * @param[out]  p_state Set to the state of the lock, to pass to
+ *                      log_backend_commit().
+ *
+ * @return  The start of the span, NULL if the backend doesn't support
+ *          reserving or has no room.  log_backend_write() must be used
+ *          instead in that case.
+ */
+char *log_backend_reserve(size_t *p_size, uint32_t *p_state);
+
+/**@brief   Write the first bytes of the span returned by
+ *          log_backend_reserve() to the device.
+ *
+ * @param[in]   length  The number of bytes written to the span, may be 0.
+ * @param[in]   state   The state set by log_backend_reserve().
+ */
+void log_backend_commit(size_t length, uint32_t state);
+
+/**@brief   Read bytes sent to the target by the host.
+ *
+ * Only called by the log task.
+ *
+ * @param[out]  buffer  The buffer to copy the bytes to.
+ * @param[in]   size    The size of buffer.
+ *
+ * @return  The number of bytes copied, 0 if there are none or the backend
+ *          can't receive.
+ */
+size_t log_backend_read(char *buffer, size_t size);
+
+/**@brief   Wait until every byte written to the backend has been sent.
+ *
+ * Used by log_dump(), which may be called with interrupts disabled, e.g.
+ * from a fault handler.  Backends that don't buffer do nothing.
+ */
+void log_backend_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_LOG_BACKEND_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,457 @@
+/**
+  ******************************************************************************
+  * File Name          : log_bench.c
+  * Description        : This file implements the benchmarks of the log
+  *                      module.
+  *
+  * log_bench_run() starts a task that runs the benchmarks once the kernel is
+  * started, so that the log task can drain the ring between the runs.
+  *
+  * The cost of a call is measured by running it in a loop with the kernel
+  * locked, so that the log task doesn't preempt the caller when it's woken.
+  * The loop is run LOG_BENCH_RUNS times, the fastest run is kept so that
+  * interrupts don't skew the result, and the cost of an empty loop is
+  * subtracted.  The loops of the LOG_* calls are short enough for the ring.
+  *
+  * The sustained rate is measured by logging as fast as possible from a task
+  * for LOG_BENCH_SUSTAIN_MS, and the producer latency by timing every call
+  * of LOG_BENCH_TASKS tasks logging at the same time.
+  *
+  * The results are logged as raw lines that start with "BENCH," followed by
+  * the benchmark, the metric and the value, so that they can be collected
+  * from the log output and compared across commits.
+  *
+  * The benchmarks log far more than a burst, so LOG_RATE_LIMIT should be off.
+  */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LOG_MODULE_NAME         bench
+#define LOG_LEVEL               LOG_LEVEL_INFO
+
+#include "log.h"
+#include "log_bench.h"
+#include "log_printf.h"
+#include "cycles.h"
+
+#include "cmsis_os.h"
+
+#if LOG_BENCHMARK
+
+/**@brief   The number of calls measured by one run of the benchmarks that
+ *          don't add to the ring.
+ */
+#define LOG_BENCH_ITERATIONS    1000
+
+/**@brief   The number of calls measured by one run of the benchmarks that
+ *          add short and long records to the ring.  They must fit in the
+ *          ring.
+ */
+#define LOG_BENCH_SHORT_CALLS   32
+#define LOG_BENCH_LONG_CALLS    16
+
+/**@brief   The number of runs of each benchmark.
+ */
+#define LOG_BENCH_RUNS          8
+
+/**@brief   The time given to the log task to drain the ring after a run, in
+ *          milliseconds.
+ */
+#define LOG_BENCH_DRAIN_MS      50
+
+/**@brief   The length of the sustained rate benchmark in milliseconds.
+ */
+#define LOG_BENCH_SUSTAIN_MS    200
+
+/**@brief   The number of tasks logging at the same time in the latency
+ *          benchmark, and the number of calls of each one.
+ */
+#define LOG_BENCH_TASKS         3
+#define LOG_BENCH_TASK_CALLS    200
+
+/**@brief   The size of the buffer of the formatting benchmarks.
+ */
+#define MAX_BENCH_LINE          64
+
+/**@brief   The number of bytes of the hex dump benchmark.
+ */
+#define LOG_BENCH_HEX_BYTES     64
+
+/**@brief   Keeps the compiler from merging or removing the loop iterations.
+ */
+#define LOG_BENCH_BARRIER()     __asm volatile ("" ::: "memory")
+
+/**@brief   A benchmark of the cost of a call.
+ */
+typedef struct
+{
+    const char *name;                   /**< Printed with the result. */
+    void (*run)(uint32_t iterations);   /**< Runs the measured call. */
+    uint32_t iterations;                /**< The number of calls of a run. */
+} log_bench_t;
+
+/**@brief   The bytes of the hex dump benchmark.
+ */
+static uint8_t m_hex_data[LOG_BENCH_HEX_BYTES];
+
+/**@brief   The longest latency of each task of the latency benchmark, in
+ *          cycles.
+ */
+static uint32_t m_latency[LOG_BENCH_TASKS];
+
+/**@brief   The number of tasks of the latency benchmark that are done.
+ */
+static volatile uint32_t m_tasks_done;
+
+/**@brief   Set by the task running the benchmarks once it's done.
+ */
+static volatile bool m_bench_done;
+
+/**@brief   The attributes of the task running the benchmarks.
+ */
+static const osThreadAttr_t m_bench_task_attributes =
+{
+    .name = "log_bench",
+    .priority = (osPriority_t)osPriorityNormal,
+    .stack_size = 512 * 4,
+};
+
+/**@brief   The attributes of the tasks of the latency benchmark.
+ */
+static const osThreadAttr_t m_latency_task_attributes =
+{
+    .name = "log_bench_latency",
+    .priority = (osPriority_t)osPriorityNormal,
+    .stack_size = 256 * 4,
+};
+
+
+/**@brief   The loop of every benchmark without a call, used as the baseline.
+ */
+static void __attribute__((noinline)) _bench_empty(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   A LOG_DEBUG call below the level of the module.
+ *
+ * With LOG_RUNTIME_LEVEL this is the load and compare of the run time level,
+ * otherwise the call is compiled out.
+ */
+static void __attribute__((noinline)) _bench_debug_suppressed(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LOG_DEBUG("Suppressed %lu\n", (unsigned long)i);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   A LOG_INFO call with a short message.
+ */
+static void __attribute__((noinline)) _bench_info_short(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LOG_INFO("Short %lu\n", (unsigned long)i);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   A LOG_INFO call with a message close to MAX_LOG_ENTRY.
+ */
+static void __attribute__((noinline)) _bench_info_long(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LOG_INFO("A long message that is close to the longest entry %s %lu 0x%08lx %d\n",
+                 "of the log module", (unsigned long)i, (unsigned long)i * 7, -1);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   A LOG_HEX_INFO call of LOG_BENCH_HEX_BYTES bytes.
+ */
+static void __attribute__((noinline)) _bench_hex(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LOG_HEX_INFO("Hex", m_hex_data, sizeof(m_hex_data), 16);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   A typical log line formatted by the newlib snprintf().
+ */
+static void __attribute__((noinline)) _bench_snprintf(uint32_t iterations)
+{
+    char buffer[MAX_BENCH_LINE];
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "%s: %s: value %lu 0x%08lx %d\n",
+                 "Info", "bench", (unsigned long)i, (unsigned long)i * 7,
+                 -1);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   The same line formatted by log_snprintf().
+ */
+static void __attribute__((noinline)) _bench_log_snprintf(uint32_t iterations)
+{
+    char buffer[MAX_BENCH_LINE];
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        log_snprintf(buffer, sizeof(buffer), "%s: %s: value %lu 0x%08lx %d\n",
+                     "Info", "bench", (unsigned long)i, (unsigned long)i * 7,
+                     -1);
+        LOG_BENCH_BARRIER();
+    }
+}
+
+
+/**@brief   The benchmarks of the cost of a call.
+ */
+static const log_bench_t m_benchmarks[] =
+{
+    { "debug_suppressed",   _bench_debug_suppressed,    LOG_BENCH_ITERATIONS },
+    { "info_short",         _bench_info_short,          LOG_BENCH_SHORT_CALLS },
+    { "info_long",          _bench_info_long,           LOG_BENCH_LONG_CALLS },
+    { "hex_64",             _bench_hex,                 LOG_BENCH_LONG_CALLS },
+    { "snprintf",           _bench_snprintf,            LOG_BENCH_ITERATIONS },
+    { "log_snprintf",       _bench_log_snprintf,        LOG_BENCH_ITERATIONS },
+};
+
+
+/**@brief   Internal function used to get the number of records that were
+ *          dropped so far.
+ */
+static uint32_t _dropped(void)
+{
+    log_stats_t stats;
+
+    log_stats_get(&stats);
+    return stats.dropped_newest + stats.dropped_oldest + stats.timed_out;
+}
+
+
+/**@brief   Internal function used to log a row of the results.
+ *
+ * @param[in] name      The benchmark.
+ * @param[in] metric    The metric.
+ * @param[in] value     The value in hundredths.
+ */
+static void _report(const char *name, const char *metric, uint32_t value)
+{
+    LOG_RAW_INFO("BENCH,%s,%s,%lu.%02lu\n", name, metric,
+                 (unsigned long)(value / 100), (unsigned long)(value % 100));
+}
+
+
+/**@brief   Internal function used to measure the fastest run of a benchmark.
+ *
+ * @param[in] run           The function of the benchmark.
+ * @param[in] iterations    The number of calls of a run.
+ *
+ * @return  The number of cycles of the fastest run.
+ */
+static uint32_t _measure(void (*run)(uint32_t iterations), uint32_t iterations)
+{
+    uint32_t best = UINT32_MAX;
+
+    for (int count = 0; count < LOG_BENCH_RUNS; count++)
+    {
+        int32_t lock = osKernelLock();
+        uint32_t start = cycles_now();
+        run(iterations);
+        uint32_t elapsed = cycles_now() - start;
+        osKernelRestoreLock(lock);
+
+        if (elapsed < best)
+        {
+            best = elapsed;
+        }
+
+        osDelay(LOG_BENCH_DRAIN_MS);
+    }
+
+    return best;
+}
+
+
+/**@brief   Internal function used to measure the cost of the calls.
+ */
+static void _bench_calls(void)
+{
+    for (size_t index = 0; index < sizeof(m_benchmarks) / sizeof(m_benchmarks[0]); index++)
+    {
+        const log_bench_t *p_bench = &m_benchmarks[index];
+        uint32_t baseline = _measure(_bench_empty, p_bench->iterations);
+        uint32_t dropped = _dropped();
+        uint32_t cycles = _measure(p_bench->run, p_bench->iterations);
+
+        cycles = (cycles > baseline) ? cycles - baseline : 0;
+
+        // Hundredths of a cycle per call
+        _report(p_bench->name, "cycles_per_call", (cycles * 100) / p_bench->iterations);
+
+        dropped = _dropped() - dropped;
+        if (dropped)
+        {
+            _report(p_bench->name, "dropped", dropped * 100);
+        }
+    }
+}
+
+
+/**@brief   Internal function used to measure the number of records per
+ *          second that reach the output device.
+ */
+static void _bench_sustained(void)
+{
+    uint32_t dropped = _dropped();
+    uint32_t count = 0;
+    uint32_t start = osKernelGetTickCount();
+    uint32_t ticks = (LOG_BENCH_SUSTAIN_MS * osKernelGetTickFreq()) / 1000;
+
+    while ((osKernelGetTickCount() - start) < ticks)
+    {
+        LOG_INFO("Sustained %lu\n", (unsigned long)count);
+        count++;
+    }
+
+    osDelay(LOG_BENCH_DRAIN_MS);
+    dropped = _dropped() - dropped;
+
+    _report("sustained", "records_per_s",
+            ((count - dropped) * 1000 / LOG_BENCH_SUSTAIN_MS) * 100);
+    _report("sustained", "dropped", dropped * 100);
+}
+
+
+/**@brief   A task of the latency benchmark.
+ *
+ * @param[in] argument  The index of the task.
+ */
+static void _latency_task(void *argument)
+{
+    uint32_t id = (uint32_t)(uintptr_t)argument;
+    uint32_t longest = 0;
+
+    for (uint32_t call = 0; call < LOG_BENCH_TASK_CALLS; call++)
+    {
+        uint32_t start = cycles_now();
+        LOG_INFO("Task %lu call %lu\n", (unsigned long)id, (unsigned long)call);
+        uint32_t elapsed = cycles_now() - start;
+
+        if (elapsed > longest)
+        {
+            longest = elapsed;
+        }
+    }
+
+    m_latency[id] = longest;
+    __atomic_fetch_add(&m_tasks_done, 1, __ATOMIC_RELEASE);
+    osThreadExit();
+}
+
+
+/**@brief   Internal function used to measure the longest time a LOG_INFO
+ *          call takes while several tasks are logging.
+ */
+static void _bench_latency(void)
+{
+    uint32_t dropped = _dropped();
+    uint32_t longest = 0;
+
+    m_tasks_done = 0;
+    for (uint32_t id = 0; id < LOG_BENCH_TASKS; id++)
+    {
+        if (NULL == osThreadNew(_latency_task, (void *)(uintptr_t)id,
+                                &m_latency_task_attributes))
+        {
+            LOG_ERROR("Can't create the latency task\n");
+            return;
+        }
+    }
+
+    while (LOG_BENCH_TASKS != __atomic_load_n(&m_tasks_done, __ATOMIC_ACQUIRE))
+    {
+        osDelay(LOG_BENCH_DRAIN_MS);
+    }
+    osDelay(LOG_BENCH_DRAIN_MS);
+
+    for (uint32_t id = 0; id < LOG_BENCH_TASKS; id++)
+    {
+        if (m_latency[id] > longest)
+        {
+            longest = m_latency[id];
+        }
+    }
+
+    _report("contention", "max_latency_cycles", longest * 100);
+    _report("contention", "max_latency_us", cycles_to_us(longest) * 100);
+    _report("contention", "dropped", (_dropped() - dropped) * 100);
+}
+
+
+/**@brief   The task running the benchmarks.
+ */
+static void _bench_task(void *argument)
+{
+    log_level_t level = log_level_get(STRINGIFY(LOG_MODULE_NAME));
+
+    // The benchmarks expect the module to be at its compiled level
+    log_level_set(STRINGIFY(LOG_MODULE_NAME), LOG_LEVEL);
+
+    for (size_t index = 0; index < sizeof(m_hex_data); index++)
+    {
+        m_hex_data[index] = (uint8_t)index;
+    }
+
+    LOG_RAW_INFO("BENCH,benchmark,metric,value\n");
+    _bench_calls();
+    _bench_sustained();
+    _bench_latency();
+
+    if (LOG_LEVEL_End != level)
+    {
+        log_level_set(STRINGIFY(LOG_MODULE_NAME), level);
+    }
+
+    __atomic_store_n(&m_bench_done, true, __ATOMIC_RELEASE);
+    osThreadExit();
+}
+
+
+void log_bench_run(void)
+{
+    if (NULL == osThreadNew(_bench_task, NULL, &m_bench_task_attributes))
+    {
+        LOG_ERROR("Can't create the benchmark task\n");
+        __atomic_store_n(&m_bench_done, true, __ATOMIC_RELEASE);
+    }
+}
+
+
+bool log_bench_done(void)
+{
+    return __atomic_load_n(&m_bench_done, __ATOMIC_ACQUIRE);
+}
+
+#endif  // LOG_BENCHMARK
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
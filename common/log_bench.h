@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * File Name          : log_bench.h
+  * Description        : This file provides an API for the benchmarks of the
+  *                      log module.
+  *
+  * The benchmarks measure the cost of the LOG_* macros in the caller's
+  * context with the DWT cycle counter, the number of records per second that
+  * reach the output device and the latency of the macros while several tasks
+  * are logging.  The results are logged as machine readable rows.
+  */
+
+#ifndef __X_LOG_BENCH_H
+#define __X_LOG_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+/**@brief   Set to 1 to run the log benchmarks when the log module is
+ *          initialized.
+ */
+#ifndef LOG_BENCHMARK
+#define LOG_BENCHMARK           0
+#endif  // LOG_BENCHMARK
+
+/**@brief   Start the task that runs the log benchmarks once the kernel is
+ *          started.
+ *
+ * cycles_init() must have been called.  Every result is logged as a raw line
+ * "BENCH,<benchmark>,<metric>,<value>".
+ */
+void log_bench_run(void);
+
+/**@brief   Check if the benchmarks started by log_bench_run() are done.
+ *
+ * The rows may still be in the log ring, give the log task time to write
+ * them before ending the process.
+ *
+ * @return  true once the last row was logged.
+ */
+bool log_bench_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_LOG_BENCH_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * File Name          : log_level.c
+  * Description        : This file implements the run time level of the log
+  *                      modules and the commands used to change them.
+  *
+  * The linker collects the log_module_t entry of every file that includes
+  * log.h into one table, see LOG_MODULE_SECTION.  Nothing registers the
+  * modules at run time, so the levels can be changed before the log task is
+  * started.
+  */
+
+#include <stdbool.h>
+#include <string.h>
+
+#define LOG_MODULE_NAME         log
+#define LOG_LEVEL               LOG_LEVEL_INFO
+
+#include "log.h"
+
+/**@brief   The start and end of the module table, set by the linker script.
+ */
+extern log_module_t __log_modules_start[];
+extern log_module_t __log_modules_end[];
+
+/**@brief   The names of the levels accepted by log_level_command().
+ *
+ * This must match the order of the values of log_level_t enumeration.
+ */
+static const char *m_level_name[] =
+{
+    "debug",
+    "info",
+    "warning",
+    "error",
+    "critical",
+    "test",
+};
+
+/**@brief   Internal function used to skip the spaces of a command.
+ *
+ * @param[in] p_str     The command.
+ *
+ * @return  The first character that isn't a space.
+ */
+static const char *_skip_spaces(const char *p_str)
+{
+    while ((' ' == *p_str) || ('\t' == *p_str))
+    {
+        p_str++;
+    }
+
+    return p_str;
+}
+
+
+/**@brief   Internal function used to get the next word of a command.
+ *
+ * @param[in,out] pp_str    The command, moved past the word.
+ * @param[out]    p_length  Set to the length of the word.
+ *
+ * @return  The start of the word, the length is 0 at the end of the command.
+ */
+static const char *_next_word(const char **pp_str, size_t *p_length)
+{
+    const char *p_word = _skip_spaces(*pp_str);
+    const char *p_end = p_word;
+
+    while (*p_end && (' ' != *p_end) && ('\t' != *p_end))
+    {
+        p_end++;
+    }
+
+    *p_length = p_end - p_word;
+    *pp_str = p_end;
+    return p_word;
+}
+
+
+/**@brief   Internal function used to test if a word of a command matches a
+ *          string.
+ */
+static bool _word_is(const char *p_word, size_t length, const char *p_str)
+{
+    return (strlen(p_str) == length) && (0 == strncmp(p_word, p_str, length));
+}
+
+
+/**@brief   Internal function used to convert a level name or number.
+ *
+ * A name may be shortened, e.g. "warn" or "d".
+ *
+ * @return  The level, LOG_LEVEL_End if the word isn't a level.
+ */
+static log_level_t _parse_level(const char *p_word, size_t length)
+{
+    if ((1 == length) && (p_word[0] >= '0') && (p_word[0] < '0' + LOG_LEVEL_End))
+    {
+        return (log_level_t)(p_word[0] - '0');
+    }
+
+    for (int level = LOG_LEVEL_Start; (0 != length) && (level < LOG_LEVEL_End); level++)
+    {
+        if (0 == strncmp(p_word, m_level_name[level], length))
+        {
+            return (log_level_t)level;
+        }
+    }
+
+    return LOG_LEVEL_End;
+}
+
+
+bool log_level_set(const char *module, log_level_t level)
+{
+    bool found = false;
+
+    if ((NULL != module) && (0 == strcmp(module, "*")))
+    {
+        module = NULL;
+    }
+
+    for (log_module_t *p_module = __log_modules_start;
+         p_module < __log_modules_end;
+         p_module++)
+    {
+        if ((NULL == module) || (0 == strcmp(module, p_module->name)))
+        {
+            p_module->level = level;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+
+log_level_t log_level_get(const char *module)
+{
+    for (log_module_t *p_module = __log_modules_start;
+         p_module < __log_modules_end;
+         p_module++)
+    {
+        if (0 == strcmp(module, p_module->name))
+        {
+            return (log_level_t)p_module->level;
+        }
+    }
+
+    return LOG_LEVEL_End;
+}
+
+
+/**@brief   Internal function used to log the level of every module.
+ *
+ * Modules with more than one file are listed once.
+ */
+static void _list_levels(void)
+{
+    for (log_module_t *p_module = __log_modules_start;
+         p_module < __log_modules_end;
+         p_module++)
+    {
+        log_module_t *p_first = __log_modules_start;
+
+        while (0 != strcmp(p_first->name, p_module->name))
+        {
+            p_first++;
+        }
+
+        if ((p_first == p_module) && (p_module->level < LOG_LEVEL_End))
+        {
+            LOG_RAW_INFO("%-12s %s\n", p_module->name,
+                         m_level_name[p_module->level]);
+        }
+    }
+}
+
+
+bool log_level_command(const char *command)
+{
+    const char *p_word;
+    size_t length;
+
+    p_word = _next_word(&command, &length);
+    if (!_word_is(p_word, length, "log"))
+    {
+        return false;
+    }
+
+    p_word = _next_word(&command, &length);
+    if (_word_is(p_word, length, "list"))
+    {
+        _list_levels();
+        return true;
+    }
+
+    if (_word_is(p_word, length, "stats"))
+    {
+        log_stats_t stats;
+
+        log_stats_get(&stats);
+        LOG_INFO("dropped %lu, overwritten %lu, timed out %lu\n",
+                 (unsigned long)stats.dropped_newest,
+                 (unsigned long)stats.dropped_oldest,
+                 (unsigned long)stats.timed_out);
+        LOG_INFO("blocked %lu, rate limited %lu\n",
+                 (unsigned long)stats.blocked,
+                 (unsigned long)stats.rate_limited);
+        return true;
+    }
+
+    if ((0 == length) || (length >= 32))
+    {
+        return false;
+    }
+
+    char module[32];
+    memcpy(module, p_word, length);
+    module[length] = '\0';
+
+    p_word = _next_word(&command, &length);
+    log_level_t level = _parse_level(p_word, length);
+    if ((LOG_LEVEL_End == level) || (0 != *_skip_spaces(command)))
+    {
+        return false;
+    }
+
+    return log_level_set(module, level);
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
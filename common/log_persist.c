@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * File Name          : log_persist.c
+  * Description        : This file implements a copy of the log output that
+  *                      survives a reset.
+  *
+  * The ring is a byte buffer and a header.  The header holds a free running
+  * count of the bytes written and a CRC of the count, updated after the bytes
+  * are copied.  If the reset happens between the two, the header is invalid
+  * and the log of that boot is lost.
+  */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "log_persist.h"
+
+#if LOG_PERSIST
+
+/**@brief   Identifies a ring written by a previous boot.
+ */
+#define LOG_PERSIST_MAGIC       0x4C4F4750  // "LOGP"
+
+/**@brief   The ring kept across resets.
+ */
+typedef struct
+{
+    uint32_t magic;                     /**< LOG_PERSIST_MAGIC. */
+    uint32_t head;                      /**< Number of bytes written. */
+    uint32_t crc;                       /**< CRC of magic and head. */
+    char data[LOG_PERSIST_SIZE];        /**< The last bytes written. */
+} log_persist_t;
+
+/**@brief   The ring, in a section that isn't cleared at startup.
+ */
+static log_persist_t m_persist __attribute__((section(".noinit")));
+
+/**@brief   Set to true once the log of the previous boot has been written.
+ */
+static bool m_enabled = false;
+
+/**@brief   Table for a nibble at a time CRC-32.
+ */
+static const uint32_t m_crc_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+
+/**@brief   Internal function used to compute the CRC of the header.
+ *
+ * @param[in]   p_persist   The ring.
+ *
+ * @return  The CRC-32 of the magic number and the count.
+ */
+static uint32_t _header_crc(const log_persist_t *p_persist)
+{
+    uint32_t words[2] = { p_persist->magic, p_persist->head };
+    const uint8_t *p_byte = (const uint8_t *)words;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t index = 0; index < sizeof(words); index++)
+    {
+        crc ^= p_byte[index];
+        crc = (crc >> 4) ^ m_crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ m_crc_table[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+
+bool log_persist_init(void)
+{
+    return (LOG_PERSIST_MAGIC == m_persist.magic) &&
+           (_header_crc(&m_persist) == m_persist.crc) &&
+           (0 != m_persist.head);
+}
+
+
+void log_persist_replay(void (*p_output)(const char *str, size_t len))
+{
+    if (log_persist_init())
+    {
+        uint32_t offset = m_persist.head & (LOG_PERSIST_SIZE - 1);
+
+        if (m_persist.head > LOG_PERSIST_SIZE)
+        {
+            // The oldest bytes are after the write position
+            p_output(&m_persist.data[offset], LOG_PERSIST_SIZE - offset);
+            p_output(m_persist.data, offset);
+        }
+        else
+        {
+            p_output(m_persist.data, m_persist.head);
+        }
+    }
+}
+
+
+void log_persist_start(void)
+{
+    m_persist.magic = LOG_PERSIST_MAGIC;
+    m_persist.head = 0;
+    m_persist.crc = _header_crc(&m_persist);
+    m_enabled = true;
+}
+
+
+void log_persist_write(const char *str, size_t len)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    if (len > LOG_PERSIST_SIZE)
+    {
+        str += len - LOG_PERSIST_SIZE;
+        m_persist.head += len - LOG_PERSIST_SIZE;
+        len = LOG_PERSIST_SIZE;
+    }
+
+    uint32_t offset = m_persist.head & (LOG_PERSIST_SIZE - 1);
+    size_t count = LOG_PERSIST_SIZE - offset;
+
+    if (count > len)
+    {
+        count = len;
+    }
+
+    memcpy(&m_persist.data[offset], str, count);
+    memcpy(m_persist.data, str + count, len - count);
+
+    m_persist.head += len;
+    m_persist.crc = _header_crc(&m_persist);
+}
+
+#else
+
+bool log_persist_init(void)
+{
+    return false;
+}
+
+
+void log_persist_replay(void (*p_output)(const char *str, size_t len))
+{
+}
+
+
+void log_persist_start(void)
+{
+}
+
+
+void log_persist_write(const char *str, size_t len)
+{
+}
+
+#endif  // LOG_PERSIST
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * File Name          : log_persist.h
+  * Description        : This file provides an API for a copy of the log
+  *                      output that survives a reset.
+  *
+  * The log task copies every byte it writes to the output device to a ring
+  * in a RAM section that isn't cleared at startup.  After a watchdog or fault
+  * reset the log of the previous boot is still in the ring, and the log task
+  * writes it out before the log of the new boot.
+  *
+  * A header with a magic number and a CRC of the write position tells a ring
+  * that was written by the previous boot from the random contents of the RAM
+  * after power on.
+  *
+  * Only the log task, or log_dump(), may call these functions.
+  */
+
+#ifndef __X_LOG_PERSIST_H
+#define __X_LOG_PERSIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**@brief   Set to 1 to keep the last LOG_PERSIST_SIZE bytes of the log output
+ *          across a reset.
+ */
+#ifndef LOG_PERSIST
+#define LOG_PERSIST             1
+#endif  // LOG_PERSIST
+
+/**@brief   The number of bytes of log output that are kept, a power of two.
+ *
+ * The ring is placed in RAM_D3, which is 16 KiB.
+ */
+#ifndef LOG_PERSIST_SIZE
+#define LOG_PERSIST_SIZE        8192
+#endif  // LOG_PERSIST_SIZE
+
+
+/**@brief   Check the ring for the log of the previous boot.
+ *
+ * @return  True if the ring holds the log of the previous boot.
+ */
+bool log_persist_init(void);
+
+/**@brief   Write the log of the previous boot, oldest byte first.
+ *
+ * Nothing is written if log_persist_init() returns false.
+ *
+ * @param[in]   p_output    Called with each part of the log, up to two.
+ */
+void log_persist_replay(void (*p_output)(const char *str, size_t len));
+
+/**@brief   Start a new log in the ring.
+ *
+ * Nothing is added to the ring before this function is called, so that the
+ * log of the previous boot isn't overwritten before it has been replayed.
+ */
+void log_persist_start(void);
+
+/**@brief   Add bytes written to the output device to the ring.
+ *
+ * The oldest bytes are overwritten once the ring is full.
+ *
+ * @param[in]   str     The bytes to add.
+ * @param[in]   len     The number of bytes to add.
+ */
+void log_persist_write(const char *str, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_LOG_PERSIST_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,678 @@
+/**
+  ******************************************************************************
+  * File Name          : log_printf.c
+  * Description        : This file implements the printf engine used by the
+  *                      log module.
+  *
+  * The format string is copied a run of characters at a time up to the next
+  * %.  A conversion without flags, width or precision, which is most of them
+  * in log messages, is written directly; the rest go through the padding
+  * code.  Numbers are converted with 32-bit arithmetic unless the value
+  * needs 64 bits, and hex and octal only use shifts.
+  */
+
+#include <float.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "log_printf.h"
+
+/**@brief   Flags of a conversion.
+ */
+#define FLAG_LEFT               0x01    /**< '-' left justify. */
+#define FLAG_PLUS               0x02    /**< '+' always write the sign. */
+#define FLAG_SPACE              0x04    /**< ' ' space for a positive sign. */
+#define FLAG_ALT                0x08    /**< '#' alternate form. */
+#define FLAG_ZERO               0x10    /**< '0' pad with zeros. */
+#define FLAG_UPPER              0x20    /**< Upper case hex digits. */
+
+/**@brief   The largest number of digits of a value, 64 bits in octal.
+ */
+#define MAX_DIGITS              22
+
+/**@brief   The number of fraction digits of %f if no precision is given.
+ */
+#define DEFAULT_FLOAT_PRECISION 6
+
+/**@brief   The largest precision of %f.
+ */
+#define MAX_FLOAT_PRECISION     9
+
+/**@brief   The output of a call.
+ */
+typedef struct
+{
+    char *buffer;                   /**< The buffer to write to. */
+    size_t size;                    /**< The size of the buffer in bytes. */
+    size_t length;                  /**< The number of characters needed. */
+} log_printf_out_t;
+
+/**@brief   A conversion specification.
+ */
+typedef struct
+{
+    uint8_t flags;                  /**< FLAG_* flags. */
+    int width;                      /**< The minimum width. */
+    int precision;                  /**< The precision, -1 if none. */
+} log_printf_spec_t;
+
+/**@brief   The digits of the conversions.
+ */
+static const char m_digits[2][16] =
+{
+    { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' },
+    { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' },
+};
+
+
+/**@brief   Internal function used to write characters to the output.
+ *
+ * @param[in,out] p_out     The output.
+ * @param[in]     str       The characters to write.
+ * @param[in]     length    The number of characters to write.
+ */
+static void _put(log_printf_out_t *p_out, const char *str, size_t length)
+{
+    if (p_out->length + 1 < p_out->size)
+    {
+        size_t left = p_out->size - 1 - p_out->length;
+
+        memcpy(&p_out->buffer[p_out->length], str,
+               (length < left) ? length : left);
+    }
+
+    p_out->length += length;
+}
+
+
+/**@brief   Internal function used to write a character several times.
+ *
+ * @param[in,out] p_out     The output.
+ * @param[in]     c         The character to write.
+ * @param[in]     count     The number of times to write it, may be negative.
+ */
+static void _put_repeat(log_printf_out_t *p_out, char c, int count)
+{
+    for (; count > 0; count--)
+    {
+        if (p_out->length + 1 < p_out->size)
+        {
+            p_out->buffer[p_out->length] = c;
+        }
+        p_out->length++;
+    }
+}
+
+
+/**@brief   Internal function used to convert a value to digits.
+ *
+ * @param[out] p_end    The end of the buffer for the digits, which are
+ *                      written backwards.
+ * @param[in]  value    The value to convert.
+ * @param[in]  base     8, 10 or 16.
+ * @param[in]  upper    True for upper case hex digits.
+ *
+ * @return  The first digit.
+ */
+static char *_to_digits(char *p_end, uint64_t value, unsigned base, bool upper)
+{
+    const char *digits = m_digits[upper ? 1 : 0];
+    uint32_t low;
+
+    if (10 != base)
+    {
+        unsigned shift = (16 == base) ? 4 : 3;
+
+        do
+        {
+            *--p_end = digits[value & (base - 1)];
+            value >>= shift;
+        } while (value);
+
+        return p_end;
+    }
+
+#if LOG_PRINTF_LONG_LONG
+    // Only the digits above 32 bits need the 64-bit division
+    while (value > UINT32_MAX)
+    {
+        *--p_end = digits[value % 10];
+        value /= 10;
+    }
+#endif
+
+    low = (uint32_t)value;
+    do
+    {
+        *--p_end = digits[low % 10];
+        low /= 10;
+    } while (low);
+
+    return p_end;
+}
+
+
+/**@brief   Internal function used to write a field with its padding.
+ *
+ * @param[in,out] p_out     The output.
+ * @param[in]     p_spec    The specification of the conversion.
+ * @param[in]     prefix    The sign or the 0x of the field.
+ * @param[in]     zeros     The number of zeros between the prefix and the
+ *                          text, not counting the zeros of FLAG_ZERO.
+ * @param[in]     text      The text of the field.
+ * @param[in]     length    The number of characters of the text.
+ */
+static void _put_field(
+    log_printf_out_t *p_out,
+    const log_printf_spec_t *p_spec,
+    const char *prefix,
+    int zeros,
+    const char *text,
+    size_t length
+)
+{
+    size_t prefix_length = strlen(prefix);
+    int pad = p_spec->width - (int)(prefix_length + zeros + length);
+
+    if ((p_spec->flags & FLAG_ZERO) && !(p_spec->flags & FLAG_LEFT))
+    {
+        zeros += (pad > 0) ? pad : 0;
+        pad = 0;
+    }
+
+    if (!(p_spec->flags & FLAG_LEFT))
+    {
+        _put_repeat(p_out, ' ', pad);
+    }
+
+    _put(p_out, prefix, prefix_length);
+    _put_repeat(p_out, '0', zeros);
+    _put(p_out, text, length);
+
+    if (p_spec->flags & FLAG_LEFT)
+    {
+        _put_repeat(p_out, ' ', pad);
+    }
+}
+
+
+/**@brief   Internal function used to write an integer conversion.
+ *
+ * @param[in,out] p_out     The output.
+ * @param[in]     p_spec    The specification of the conversion.
+ * @param[in]     value     The magnitude of the value.
+ * @param[in]     negative  True if the value is negative.
+ * @param[in]     base      8, 10 or 16.
+ */
+static void _put_integer(
+    log_printf_out_t *p_out,
+    const log_printf_spec_t *p_spec,
+    uint64_t value,
+    bool negative,
+    unsigned base
+)
+{
+    char digits[MAX_DIGITS];
+    char *p_end = &digits[MAX_DIGITS];
+    char *p_start = p_end;
+    const char *prefix = "";
+    int zeros = 0;
+
+    // A precision of 0 writes nothing for a value of 0
+    if (value || (0 != p_spec->precision))
+    {
+        p_start = _to_digits(p_end, value, base, p_spec->flags & FLAG_UPPER);
+    }
+
+    if (p_spec->precision > p_end - p_start)
+    {
+        zeros = p_spec->precision - (p_end - p_start);
+    }
+
+    if (10 == base)
+    {
+        if (negative)
+        {
+            prefix = "-";
+        }
+        else if (p_spec->flags & FLAG_PLUS)
+        {
+            prefix = "+";
+        }
+        else if (p_spec->flags & FLAG_SPACE)
+        {
+            prefix = " ";
+        }
+    }
+    else if (p_spec->flags & FLAG_ALT)
+    {
+        if ((8 == base) && (0 == zeros) && ((p_start == p_end) || ('0' != *p_start)))
+        {
+            zeros = 1;
+        }
+        else if ((16 == base) && value)
+        {
+            prefix = (p_spec->flags & FLAG_UPPER) ? "0X" : "0x";
+        }
+    }
+
+    // The zeros of FLAG_ZERO are ignored if a precision is given
+    log_printf_spec_t spec = *p_spec;
+    if (spec.precision >= 0)
+    {
+        spec.flags &= ~FLAG_ZERO;
+    }
+
+    _put_field(p_out, &spec, prefix, zeros, p_start, p_end - p_start);
+}
+
+
+#if LOG_PRINTF_FLOAT
+/**@brief   Internal function used to write a floating point conversion.
+ *
+ * Values of 2^64 or more are written as "ovf", and halves are rounded up.
+ *
+ * @param[in,out] p_out     The output.
+ * @param[in]     p_spec    The specification of the conversion.
+ * @param[in]     value     The value.
+ */
+static void _put_float(
+    log_printf_out_t *p_out,
+    const log_printf_spec_t *p_spec,
+    double value
+)
+{
+    static const uint32_t powers[MAX_FLOAT_PRECISION + 1] =
+    {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000,
+    };
+    char text[MAX_DIGITS + 1 + MAX_FLOAT_PRECISION];
+    char *p_end = &text[sizeof(text)];
+    char *p_start;
+    const char *prefix = "";
+    log_printf_spec_t spec = *p_spec;
+    int precision = spec.precision;
+    bool negative = value < 0;
+
+    if (negative)
+    {
+        value = -value;
+    }
+
+    if (negative)
+    {
+        prefix = "-";
+    }
+    else if (spec.flags & FLAG_PLUS)
+    {
+        prefix = "+";
+    }
+    else if (spec.flags & FLAG_SPACE)
+    {
+        prefix = " ";
+    }
+
+    if (value != value)
+    {
+        spec.flags &= ~FLAG_ZERO;
+        _put_field(p_out, &spec, prefix, 0, "nan", 3);
+        return;
+    }
+
+    if (value >= 18446744073709551616.0)
+    {
+        spec.flags &= ~FLAG_ZERO;
+        _put_field(p_out, &spec, prefix, 0, (value > DBL_MAX) ? "inf" : "ovf", 3);
+        return;
+    }
+
+    if (precision < 0)
+    {
+        precision = DEFAULT_FLOAT_PRECISION;
+    }
+    else if (precision > MAX_FLOAT_PRECISION)
+    {
+        precision = MAX_FLOAT_PRECISION;
+    }
+
+    // Round to the precision, carrying into the integer part
+    uint64_t whole = (uint64_t)value;
+    double scaled = (value - (double)whole) * powers[precision] + 0.5;
+    uint32_t fraction = (uint32_t)scaled;
+
+    if (fraction >= powers[precision])
+    {
+        fraction = 0;
+        whole++;
+    }
+
+    p_start = p_end;
+    if (precision)
+    {
+        for (int count = 0; count < precision; count++)
+        {
+            *--p_start = m_digits[0][fraction % 10];
+            fraction /= 10;
+        }
+        *--p_start = '.';
+    }
+    else if (spec.flags & FLAG_ALT)
+    {
+        *--p_start = '.';
+    }
+    p_start = _to_digits(p_start, whole, 10, false);
+
+    _put_field(p_out, &spec, prefix, 0, p_start, p_end - p_start);
+}
+#endif  // LOG_PRINTF_FLOAT
+
+
+int log_vsnprintf(char *buffer, size_t size, const char *fmt, va_list ap)
+{
+    log_printf_out_t out = { buffer, size, 0 };
+
+    while (*fmt)
+    {
+        // Copy the text up to the next conversion
+        const char *p_percent = fmt;
+        while (*p_percent && ('%' != *p_percent))
+        {
+            p_percent++;
+        }
+        _put(&out, fmt, p_percent - fmt);
+        if (0 == *p_percent)
+        {
+            break;
+        }
+        fmt = p_percent + 1;
+
+        log_printf_spec_t spec = { 0, 0, -1 };
+        bool simple = true;
+
+        for (;; fmt++)
+        {
+            uint8_t flag = ('-' == *fmt) ? FLAG_LEFT :
+                           ('+' == *fmt) ? FLAG_PLUS :
+                           (' ' == *fmt) ? FLAG_SPACE :
+                           ('#' == *fmt) ? FLAG_ALT :
+                           ('0' == *fmt) ? FLAG_ZERO : 0;
+            if (0 == flag)
+            {
+                break;
+            }
+            spec.flags |= flag;
+            simple = false;
+        }
+
+        if ('*' == *fmt)
+        {
+            spec.width = va_arg(ap, int);
+            if (spec.width < 0)
+            {
+                spec.flags |= FLAG_LEFT;
+                spec.width = -spec.width;
+            }
+            fmt++;
+            simple = false;
+        }
+        while ((*fmt >= '0') && (*fmt <= '9'))
+        {
+            spec.width = spec.width * 10 + (*fmt++ - '0');
+            simple = false;
+        }
+
+        if ('.' == *fmt)
+        {
+            fmt++;
+            spec.precision = 0;
+            if ('*' == *fmt)
+            {
+                spec.precision = va_arg(ap, int);
+                fmt++;
+            }
+            while ((*fmt >= '0') && (*fmt <= '9'))
+            {
+                spec.precision = spec.precision * 10 + (*fmt++ - '0');
+            }
+            simple = false;
+        }
+
+        // The number of bytes of the argument
+        size_t arg_size = sizeof(int);
+        switch (*fmt)
+        {
+            case 'h':
+                arg_size = ('h' == fmt[1]) ? sizeof(char) : sizeof(short);
+                fmt += ('h' == fmt[1]) ? 2 : 1;
+                break;
+
+            case 'l':
+                if ('l' == fmt[1])
+                {
+                    arg_size = sizeof(long long);
+                    fmt++;
+                }
+                else
+                {
+                    arg_size = sizeof(long);
+                }
+                fmt++;
+                break;
+
+            case 'j':
+                arg_size = sizeof(intmax_t);
+                fmt++;
+                break;
+
+            case 'z':
+                arg_size = sizeof(size_t);
+                fmt++;
+                break;
+
+            case 't':
+                arg_size = sizeof(ptrdiff_t);
+                fmt++;
+                break;
+
+            default:
+                break;
+        }
+
+        char conversion = *fmt;
+        if (0 == conversion)
+        {
+            break;
+        }
+        fmt++;
+
+        uint64_t value;
+        unsigned base = 10;
+
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+            {
+                int64_t number;
+
+                // Shorter arguments are promoted to int
+                if (arg_size > sizeof(long))
+                {
+                    number = va_arg(ap, long long);
+                }
+                else if (arg_size > sizeof(int))
+                {
+                    number = va_arg(ap, long);
+                }
+                else
+                {
+                    number = va_arg(ap, int);
+                    number = (sizeof(char) == arg_size) ? (signed char)number :
+                             (sizeof(short) == arg_size) ? (short)number : number;
+                }
+#if !LOG_PRINTF_LONG_LONG
+                number = (int32_t)number;
+#endif
+                bool negative = number < 0;
+
+                value = negative ? -(uint64_t)number : (uint64_t)number;
+                if (simple && (value <= UINT32_MAX))
+                {
+                    char digits[MAX_DIGITS];
+                    char *p_end = &digits[MAX_DIGITS];
+                    char *p_start = _to_digits(p_end, value, 10, false);
+
+                    if (negative)
+                    {
+                        *--p_start = '-';
+                    }
+                    _put(&out, p_start, p_end - p_start);
+                }
+                else
+                {
+                    _put_integer(&out, &spec, value, negative, 10);
+                }
+                break;
+            }
+
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                base = ('o' == conversion) ? 8 : ('u' == conversion) ? 10 : 16;
+                if ('X' == conversion)
+                {
+                    spec.flags |= FLAG_UPPER;
+                }
+
+                if (arg_size > sizeof(long))
+                {
+                    value = va_arg(ap, unsigned long long);
+                }
+                else if (arg_size > sizeof(int))
+                {
+                    value = va_arg(ap, unsigned long);
+                }
+                else
+                {
+                    value = va_arg(ap, unsigned int);
+                    value = (sizeof(char) == arg_size) ? (unsigned char)value :
+                            (sizeof(short) == arg_size) ? (unsigned short)value : value;
+                }
+#if !LOG_PRINTF_LONG_LONG
+                value = (uint32_t)value;
+#endif
+                if (simple)
+                {
+                    char digits[MAX_DIGITS];
+                    char *p_end = &digits[MAX_DIGITS];
+                    char *p_start = _to_digits(p_end, value, base,
+                                               spec.flags & FLAG_UPPER);
+
+                    _put(&out, p_start, p_end - p_start);
+                }
+                else
+                {
+                    _put_integer(&out, &spec, value, false, base);
+                }
+                break;
+
+            case 'p':
+                spec.flags |= FLAG_ALT;
+                _put_integer(&out, &spec, (uintptr_t)va_arg(ap, void *), false, 16);
+                break;
+
+            case 'c':
+            {
+                char c = (char)va_arg(ap, int);
+
+                spec.flags &= ~FLAG_ZERO;
+                _put_field(&out, &spec, "", 0, &c, 1);
+                break;
+            }
+
+            case 's':
+            {
+                const char *str = va_arg(ap, const char *);
+                size_t length = 0;
+
+                if (NULL == str)
+                {
+                    str = "(null)";
+                }
+
+                if (spec.precision < 0)
+                {
+                    length = strlen(str);
+                }
+                else
+                {
+                    // The string doesn't need to be NULL terminated
+                    while ((length < (size_t)spec.precision) && str[length])
+                    {
+                        length++;
+                    }
+                }
+
+                if (simple)
+                {
+                    _put(&out, str, length);
+                }
+                else
+                {
+                    spec.flags &= ~FLAG_ZERO;
+                    _put_field(&out, &spec, "", 0, str, length);
+                }
+                break;
+            }
+
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+            {
+                double number = va_arg(ap, double);
+
+#if LOG_PRINTF_FLOAT
+                _put_float(&out, &spec, number);
+#else
+                (void)number;
+                _put(&out, "?", 1);
+#endif
+                break;
+            }
+
+            default:
+                // %% and unknown conversions are written as is
+                _put(&out, &conversion, 1);
+                break;
+        }
+    }
+
+    if (size)
+    {
+        buffer[(out.length < size) ? out.length : size - 1] = '\0';
+    }
+
+    return (int)out.length;
+}
+
+
+int log_snprintf(char *buffer, size_t size, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    int written = log_vsnprintf(buffer, size, fmt, ap);
+    va_end(ap);
+
+    return written;
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * File Name          : log_printf.h
+  * Description        : This file provides an API for the printf engine used
+  *                      by the log module.
+  *
+  * The engine formats into a caller supplied buffer.  It doesn't use the heap
+  * or the newlib reent structure, so it can be called from any task or
+  * interrupt, and its stack use is bounded.
+  *
+  * Supported: the flags "-+ #0", the width and the precision, including "*",
+  * the lengths hh, h, l, ll, j, z and t, and the conversions d, i, u, o, x,
+  * X, c, s, p and %.  The floating point conversions are only formatted if
+  * LOG_PRINTF_FLOAT is set.  %n isn't supported.
+  */
+
+#ifndef __X_LOG_PRINTF_H
+#define __X_LOG_PRINTF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**@brief   Set to 1 to format %f, %F, %e, %E, %g and %G.
+ *
+ * All of them are formatted as %f.  Without it the double argument is
+ * skipped and "?" is written, which keeps the soft float code out of the
+ * image.
+ */
+#ifndef LOG_PRINTF_FLOAT
+#define LOG_PRINTF_FLOAT        0
+#endif  // LOG_PRINTF_FLOAT
+
+/**@brief   Set to 1 to format the 64-bit values of %ll and %j.
+ *
+ * Without it only the low 32 bits are formatted, which keeps the 64-bit
+ * division out of the image.
+ */
+#ifndef LOG_PRINTF_LONG_LONG
+#define LOG_PRINTF_LONG_LONG    1
+#endif  // LOG_PRINTF_LONG_LONG
+
+
+/**@brief   Format a string like vsnprintf().
+ *
+ * @param[out] buffer   The buffer to format into, may be NULL if size is 0.
+ * @param[in]  size     The size of the buffer in bytes.  The output is
+ *                      truncated to size - 1 characters and NULL terminated.
+ * @param[in]  fmt      A printf format string.
+ * @param[in]  ap       The arguments of the format string.
+ *
+ * @return  The number of characters the whole output needs, not counting
+ *          the NULL terminator.
+ */
+int log_vsnprintf(char *buffer, size_t size, const char *fmt, va_list ap);
+
+/**@brief   Format a string like snprintf(), see log_vsnprintf().
+ */
+int log_snprintf(char *buffer, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_LOG_PRINTF_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
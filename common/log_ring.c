@@ -0,0 +1,185 @@
+/**
+  ******************************************************************************
+  * File Name          : log_ring.c
+  * Description        : This file implements a lock-free multiple producer,
+  *                      single consumer ring of variable length records.
+  *
+  * Every record starts with a 32-bit header word holding the size of the
+  * record, including the header, and the RECORD_COMMITTED flag.  A record
+  * never wraps around the end of the buffer, if it doesn't fit a padding
+  * record fills the end of the buffer and the record starts at offset 0.
+  *
+  * The consumer clears every byte it frees before moving the tail.  The space
+  * between the head and the tail is therefore always zero, and a header that
+  * is zero or doesn't have RECORD_COMMITTED set can't be read yet.
+  */
+
+#include <assert.h>
+#include <string.h>
+
+#include "log_ring.h"
+#include "tcm.h"
+
+#define RECORD_SIZE_MASK        0x0000FFFF  /**< Size of the record in bytes. */
+#define RECORD_COMMITTED        0x00010000  /**< The record can be read. */
+#define RECORD_PADDING          0x00020000  /**< Skip to the start of buffer. */
+
+/**@brief   Round a length up to a multiple of the record alignment.
+ */
+#define RECORD_ALIGN(len)       (((len) + 3) & ~3UL)
+
+
+/**@brief   Internal function used to get the header of the record at a
+ *          position of the ring.
+ *
+ * @param   p_ring[in]      The ring.
+ * @param   position[in]    A head or tail counter value.
+ *
+ * @return  A pointer to the header word.
+ */
+static uint32_t *_header(log_ring_t *p_ring, uint32_t position)
+{
+    return (uint32_t *)&p_ring->p_buffer[position & (p_ring->size - 1)];
+}
+
+
+void log_ring_init(log_ring_t *p_ring, void *p_buffer, uint32_t size)
+{
+    // The positions are masked with size - 1, and a padding record of up to
+    // the size of the ring must fit in RECORD_SIZE_MASK
+    assert((size >= 2 * LOG_RING_HEADER_SIZE) && (0 == (size & (size - 1))));
+    assert(size <= RECORD_SIZE_MASK + 1);
+
+    memset(p_buffer, 0, size);
+
+    p_ring->p_buffer = p_buffer;
+    p_ring->size = size;
+    p_ring->head = 0;
+    p_ring->tail = 0;
+    p_ring->locked = false;
+}
+
+
+// The producer functions are called by every LOG_* macro, from the tasks and
+// the interrupts, and don't call anything else
+RAMFUNC void *log_ring_reserve(log_ring_t *p_ring, size_t length)
+{
+    if (length > LOG_RING_MAX_RECORD)
+    {
+        return NULL;
+    }
+
+    uint32_t need = RECORD_ALIGN(length + LOG_RING_HEADER_SIZE);
+    uint32_t head = __atomic_load_n(&p_ring->head, __ATOMIC_RELAXED);
+    uint32_t padding;
+    uint32_t next;
+
+    if (need > p_ring->size)
+    {
+        return NULL;
+    }
+
+    do
+    {
+        // The acquire pairs with the release in log_ring_release(), the freed
+        // space has been cleared once the new tail is seen.
+        uint32_t tail = __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE);
+        uint32_t offset = head & (p_ring->size - 1);
+
+        padding = (offset + need > p_ring->size) ? p_ring->size - offset : 0;
+        next = head + padding + need;
+
+        if (next - tail > p_ring->size)
+        {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&p_ring->head, &head, next, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (padding)
+    {
+        __atomic_store_n(_header(p_ring, head),
+                         padding | RECORD_PADDING | RECORD_COMMITTED,
+                         __ATOMIC_RELEASE);
+        head += padding;
+    }
+
+    // The consumer ignores the header until RECORD_COMMITTED is set
+    uint32_t *p_header = _header(p_ring, head);
+    __atomic_store_n(p_header, need, __ATOMIC_RELAXED);
+
+    return p_header + 1;
+}
+
+
+RAMFUNC void log_ring_commit(log_ring_t *p_ring, void *p_record)
+{
+    uint32_t *p_header = (uint32_t *)p_record - 1;
+
+    // The release makes the contents of the record visible before the flag
+    __atomic_store_n(p_header, *p_header | RECORD_COMMITTED, __ATOMIC_RELEASE);
+}
+
+
+bool log_ring_lock(log_ring_t *p_ring)
+{
+    return !__atomic_test_and_set(&p_ring->locked, __ATOMIC_ACQUIRE);
+}
+
+
+void log_ring_unlock(log_ring_t *p_ring)
+{
+    __atomic_clear(&p_ring->locked, __ATOMIC_RELEASE);
+}
+
+
+void *log_ring_peek(log_ring_t *p_ring, size_t *p_length)
+{
+    for (;;)
+    {
+        uint32_t *p_header = _header(p_ring, p_ring->tail);
+        uint32_t header = __atomic_load_n(p_header, __ATOMIC_ACQUIRE);
+
+        if (!(header & RECORD_COMMITTED))
+        {
+            return NULL;
+        }
+
+        if (header & RECORD_PADDING)
+        {
+            log_ring_release(p_ring);
+            continue;
+        }
+
+        if (p_length)
+        {
+            *p_length = (header & RECORD_SIZE_MASK) - LOG_RING_HEADER_SIZE;
+        }
+        return p_header + 1;
+    }
+}
+
+
+void log_ring_release(log_ring_t *p_ring)
+{
+    uint32_t tail = p_ring->tail;
+    uint32_t *p_header = _header(p_ring, tail);
+    uint32_t size = *p_header & RECORD_SIZE_MASK;
+
+    memset(p_header, 0, size);
+
+    // The release makes the cleared space visible before producers reuse it
+    __atomic_store_n(&p_ring->tail, tail + size, __ATOMIC_RELEASE);
+}
+
+
+bool log_ring_readable(log_ring_t *p_ring)
+{
+    uint32_t tail = __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE);
+
+    return 0 != (__atomic_load_n(_header(p_ring, tail), __ATOMIC_ACQUIRE)
+                 & RECORD_COMMITTED);
+}
+
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,139 @@
+/**
+  ******************************************************************************
+  * File Name          : log_ring.h
+  * Description        : This file provides an API for a lock-free multiple
+  *                      producer, single consumer ring of variable length
+  *                      records used by the log module.
+  *
+  * Producers reserve space for a record, fill it in and commit it.  Reserving
+  * only needs a compare and swap of the head, so any number of threads and
+  * interrupts can add records at the same time without a critical section.
+  *
+  * The consumer must hold the ring lock, see log_ring_lock(), while it reads
+  * records with log_ring_peek() and frees them with log_ring_release().
+  * Records are read in the order that they were reserved.  A record that has
+  * been reserved, but not committed yet, blocks the records behind it until
+  * it is committed.
+  *
+  * The module only depends on the GCC __atomic builtins so that it can be
+  * built for the host as well as the target.
+  */
+
+#ifndef __X_LOG_RING_H
+#define __X_LOG_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**@brief   The number of bytes added to every record by the ring.
+ */
+#define LOG_RING_HEADER_SIZE    sizeof(uint32_t)
+
+/**@brief   The largest record, in bytes, that can be stored in a ring.
+ */
+#define LOG_RING_MAX_RECORD     (0xFFFC - LOG_RING_HEADER_SIZE)
+
+/**@brief   The state of a ring.
+ *
+ * The head and tail are free running byte counters, the offset in the buffer
+ * is the counter modulo the size of the buffer.
+ */
+typedef struct
+{
+    uint8_t *p_buffer;          /**< The storage of the ring. */
+    uint32_t size;              /**< Size of p_buffer, a power of two. */
+    uint32_t head;              /**< Where the next record is reserved. */
+    uint32_t tail;              /**< Where the next record is read. */
+    bool locked;                /**< True while a consumer owns the tail. */
+} log_ring_t;
+
+
+/**@brief   Initialize a ring.
+ *
+ * @param[out]  p_ring      The ring to initialize.
+ * @param[in]   p_buffer    The storage of the ring.  It must be 4 byte
+ *                          aligned and is cleared by this function.
+ * @param[in]   size        The size of p_buffer in bytes, a power of two of at
+ *                          most 64 KiB.
+ */
+void log_ring_init(log_ring_t *p_ring, void *p_buffer, uint32_t size);
+
+/**@brief   Reserve space for a record.
+ *
+ * This function can be called from any thread or interrupt.  The record must
+ * be committed with log_ring_commit() once it's filled in.
+ *
+ * @param[in]   p_ring      The ring to reserve the record in.
+ * @param[in]   length      The number of bytes in the record.
+ *
+ * @return  A 4 byte aligned pointer to the record, NULL if the ring doesn't
+ *          have enough free space.
+ */
+void *log_ring_reserve(log_ring_t *p_ring, size_t length);
+
+/**@brief   Commit a record so that it can be read by the consumer.
+ *
+ * @param[in]   p_ring      The ring the record was reserved in.
+ * @param[in]   p_record    The value returned by log_ring_reserve().
+ */
+void log_ring_commit(log_ring_t *p_ring, void *p_record);
+
+/**@brief   Try to become the consumer of a ring.
+ *
+ * @param[in]   p_ring      The ring to lock.
+ *
+ * @return  True if the caller is now the consumer, false if another caller
+ *          already holds the lock.
+ */
+bool log_ring_lock(log_ring_t *p_ring);
+
+/**@brief   Give up being the consumer of a ring.
+ *
+ * @param[in]   p_ring      The ring to unlock.
+ */
+void log_ring_unlock(log_ring_t *p_ring);
+
+/**@brief   Get the oldest committed record without removing it.
+ *
+ * The caller must hold the ring lock.
+ *
+ * @param[in]   p_ring      The ring to read from.
+ * @param[out]  p_length    Set to the length of the record, rounded up to a
+ *                          multiple of 4 bytes.  May be NULL.
+ *
+ * @return  A pointer to the record, NULL if the oldest record isn't
+ *          committed yet or the ring is empty.
+ */
+void *log_ring_peek(log_ring_t *p_ring, size_t *p_length);
+
+/**@brief   Remove the record returned by log_ring_peek() from the ring.
+ *
+ * The caller must hold the ring lock.
+ *
+ * @param[in]   p_ring      The ring to remove the record from.
+ */
+void log_ring_release(log_ring_t *p_ring);
+
+/**@brief   Test if the ring has a record that can be read.
+ *
+ * The lock isn't needed, the result is only a hint if another caller is
+ * adding or removing records at the same time.
+ *
+ * @param[in]   p_ring      The ring to test.
+ *
+ * @return  True if the oldest record is committed, false otherwise.
+ */
+bool log_ring_readable(log_ring_t *p_ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_LOG_RING_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * File Name          : log_rtt.c
+  * Description        : This file implements the log backend that writes to
+  *                      the SEGGER RTT up-buffer.
+  *
+  * log_backend_reserve() takes the RTT lock and returns the free space
+  * between the write offset and the read offset, or the end of the buffer.
+  * The log task copies a formatted block straight into it and
+  * log_backend_commit() updates the write offset once and releases the lock.
+  * The host sees either none or all of the block.  The lock masks the
+  * interrupts up to SEGGER_RTT_MAX_INTERRUPT_PRIORITY for as long as the copy
+  * takes.
+  */
+
+#include "log_backend.h"
+
+#if LOG_BACKEND_RTT
+
+#include "SEGGER_RTT.h"
+
+#include "stm32h7xx.h"
+
+/**@brief   The RTT buffer ID used to write log messages to.
+ */
+#define RTT_TERMINAL_ID         0
+
+/**@brief   Get the up-buffer used for log messages.
+ *
+ * The control block is accessed the same way as SEGGER_RTT.c does so that
+ * SEGGER_RTT_UNCACHED_OFF is honored.
+ */
+#define RTT_UP_BUFFER()                                                         \
+    ((SEGGER_RTT_BUFFER_UP *)((char *)&_SEGGER_RTT.aUp[RTT_TERMINAL_ID] + SEGGER_RTT_UNCACHED_OFF))
+
+void log_backend_init(void)
+{
+    SEGGER_RTT_Init();
+}
+
+
+void log_backend_write(const char *str, size_t len)
+{
+    SEGGER_RTT_Write(RTT_TERMINAL_ID, str, len);
+}
+
+
+char *log_backend_reserve(size_t *p_size, uint32_t *p_state)
+{
+    SEGGER_RTT_BUFFER_UP *p_ring = RTT_UP_BUFFER();
+    unsigned wr_off;
+    unsigned rd_off;
+
+    // Same lock as SEGGER_RTT_LOCK(), which can't be split across functions
+    *p_state = __get_BASEPRI();
+    __set_BASEPRI_MAX(SEGGER_RTT_MAX_INTERRUPT_PRIORITY);
+
+    wr_off = p_ring->WrOff;
+    rd_off = p_ring->RdOff;
+
+    if (rd_off <= wr_off)
+    {
+        // Up to the end of the buffer, the write offset must not catch up
+        // with the read offset when it wraps around.
+        *p_size = p_ring->SizeOfBuffer - wr_off - ((0 == rd_off) ? 1 : 0);
+    }
+    else
+    {
+        *p_size = rd_off - wr_off - 1;
+    }
+
+    return (char *)p_ring->pBuffer + wr_off + SEGGER_RTT_UNCACHED_OFF;
+}
+
+
+void log_backend_commit(size_t length, uint32_t state)
+{
+    SEGGER_RTT_BUFFER_UP *p_ring = RTT_UP_BUFFER();
+    unsigned wr_off = p_ring->WrOff + length;
+
+    if (wr_off == p_ring->SizeOfBuffer)
+    {
+        wr_off = 0;
+    }
+
+    // Force the data to be written before the write offset
+    RTT__DMB();
+    p_ring->WrOff = wr_off;
+
+    __set_BASEPRI(state);
+}
+
+
+size_t log_backend_read(char *buffer, size_t size)
+{
+    return SEGGER_RTT_Read(RTT_TERMINAL_ID, buffer, size);
+}
+
+
+void log_backend_flush(void)
+{
+    // The debugger reads the up-buffer, nothing to do
+}
+
+#endif  // LOG_BACKEND_RTT
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
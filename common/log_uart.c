@@ -0,0 +1,367 @@
+/**
+  ******************************************************************************
+  * File Name          : log_uart.c
+  * Description        : This file implements the log backend that writes to
+  *                      USART3, the ST-LINK virtual COM port, using DMA.
+  *
+  * The backend has two TX buffers.  The log task formats lines into one of
+  * them while DMA1 stream 0 sends the other one.  When a transfer completes
+  * the buffers are swapped and the next transfer is started from the
+  * interrupt, so the log task only waits if it fills a buffer before the
+  * other one has been sent.
+  *
+  * main.c initializes huart3 after log_task_init(), so the DMA and the baud
+  * rate are set up the first time the log task writes after that.  Anything
+  * written before then stays in the buffer.  If they can't be set up, the
+  * output is dropped.
+  */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "log_backend.h"
+
+#if LOG_BACKEND_UART
+
+#include "main.h"
+#include "cmsis_os.h"
+
+/**@brief   The baud rate of the log UART.
+ *
+ * The ST-LINK V3 virtual COM port supports rates of several Mbaud.
+ */
+#ifndef LOG_UART_BAUDRATE
+#define LOG_UART_BAUDRATE       921600
+#endif
+
+/**@brief   The size of each of the two TX buffers in bytes.
+ */
+#ifndef LOG_UART_BUFFER_SIZE
+#define LOG_UART_BUFFER_SIZE    1024
+#endif
+
+/**@brief   The priority of the DMA and UART interrupts.
+ *
+ * They don't call the RTOS, but they can't be masked by the RTOS either if
+ * they are more urgent than configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ */
+#define LOG_UART_IRQ_PRIORITY   5
+
+/**@brief   The BASEPRI value used to lock the buffers.
+ *
+ * It masks the DMA and UART interrupts and the RTOS context switch.
+ */
+#define LOG_UART_LOCK_PRIORITY  (LOG_UART_IRQ_PRIORITY << (8 - __NVIC_PRIO_BITS))
+
+/**@brief   The UART initialized by main.c.
+ */
+extern UART_HandleTypeDef huart3;
+
+/**@brief   The DMA stream used to send the TX buffers.
+ */
+static DMA_HandleTypeDef m_hdma_tx;
+
+/**@brief   The TX buffers.
+ *
+ * DMA1 can't access the TCM, so the buffers are placed in the D2 SRAM.  It
+ * isn't cached, see cache.h, so the buffers need no cache maintenance.
+ */
+static uint8_t m_buffer[2][LOG_UART_BUFFER_SIZE] __attribute__((section(".dma_buffer"), aligned(32)));
+
+/**@brief   The index of the buffer being filled.
+ */
+static volatile uint8_t m_fill;
+
+/**@brief   The number of bytes in the buffer being filled.
+ */
+static volatile size_t m_fill_len;
+
+/**@brief   Set to true while DMA is sending the other buffer.
+ */
+static volatile bool m_busy;
+
+/**@brief   Set to true once the DMA and the baud rate have been set up.
+ */
+static bool m_ready;
+
+/**@brief   Set to true if the UART or the DMA can't be set up, the output
+ *          is dropped from then on.
+ *
+ * It's set before Error_Handler() is called, which logs and calls
+ * log_dump(), so that the backend doesn't try to set them up again.
+ */
+static bool m_failed;
+
+
+/**@brief   Internal function used to test if the caller is an interrupt.
+ *
+ * @return  True if called from an interrupt or exception handler.
+ */
+static inline bool _in_isr(void)
+{
+    return 0 != __get_IPSR();
+}
+
+
+/**@brief   Internal function used to lock the buffers.
+ *
+ * The state is kept by the caller, so an interrupt or a task of higher
+ * priority that locks the buffers while they're locked restores its own.
+ *
+ * @return  The BASEPRI value to pass to _unlock().
+ */
+static uint32_t _lock(void)
+{
+    uint32_t state = __get_BASEPRI();
+
+    __set_BASEPRI_MAX(LOG_UART_LOCK_PRIORITY);
+    return state;
+}
+
+
+/**@brief   Internal function used to unlock the buffers.
+ *
+ * @param   state[in]   The value returned by _lock().
+ */
+static void _unlock(uint32_t state)
+{
+    __set_BASEPRI(state);
+}
+
+
+/**@brief   Internal function used to set up the DMA and the baud rate once
+ *          main.c has initialized huart3.
+ *
+ * Only called from the log task, outside of the lock, since the HAL uses the
+ * tick for its timeouts.
+ */
+static void _setup(void)
+{
+    if (m_ready || m_failed || (HAL_UART_STATE_RESET == huart3.gState))
+    {
+        return;
+    }
+
+    if (huart3.Init.BaudRate != LOG_UART_BAUDRATE)
+    {
+        huart3.Init.BaudRate = LOG_UART_BAUDRATE;
+        if (HAL_OK != HAL_UART_Init(&huart3))
+        {
+            m_failed = true;
+            Error_Handler();
+            return;
+        }
+    }
+
+    __HAL_RCC_D2SRAM1_CLK_ENABLE();
+    __HAL_RCC_D2SRAM2_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    m_hdma_tx.Instance = DMA1_Stream0;
+    m_hdma_tx.Init.Request = DMA_REQUEST_USART3_TX;
+    m_hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    m_hdma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    m_hdma_tx.Init.MemInc = DMA_MINC_ENABLE;
+    m_hdma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    m_hdma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    m_hdma_tx.Init.Mode = DMA_NORMAL;
+    m_hdma_tx.Init.Priority = DMA_PRIORITY_LOW;
+    m_hdma_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_OK != HAL_DMA_Init(&m_hdma_tx))
+    {
+        m_failed = true;
+        Error_Handler();
+        return;
+    }
+    __HAL_LINKDMA(&huart3, hdmatx, m_hdma_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, LOG_UART_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+    HAL_NVIC_SetPriority(USART3_IRQn, LOG_UART_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(USART3_IRQn);
+
+    m_ready = true;
+}
+
+
+/**@brief   Internal function used to send the buffer being filled if DMA is
+ *          idle.  The buffers must be locked, or the caller must be the DMA
+ *          interrupt.
+ */
+static void _start_transfer(void)
+{
+    if (!m_ready || m_busy || (0 == m_fill_len))
+    {
+        return;
+    }
+
+    if (HAL_OK == HAL_UART_Transmit_DMA(&huart3, m_buffer[m_fill], m_fill_len))
+    {
+        m_busy = true;
+        m_fill ^= 1;
+        m_fill_len = 0;
+    }
+}
+
+
+/**@brief   Internal function used to finish the current transfer without the
+ *          DMA and UART interrupts.  The buffers must be locked.
+ *
+ * This is used when the interrupts may never run, e.g. log_dump() called
+ * from a fault handler.
+ */
+static void _finish_polling(void)
+{
+    if (m_busy)
+    {
+        while (0 != __HAL_DMA_GET_COUNTER(&m_hdma_tx))
+        {
+        }
+        HAL_UART_AbortTransmit(&huart3);
+        m_busy = false;
+    }
+}
+
+
+void log_backend_init(void)
+{
+    m_fill = 0;
+    m_fill_len = 0;
+    m_busy = false;
+}
+
+
+void log_backend_write(const char *str, size_t len)
+{
+    bool in_isr = _in_isr();
+
+    if (!in_isr)
+    {
+        _setup();
+    }
+
+    while (len && !m_failed)
+    {
+        uint32_t state = _lock();
+
+        size_t count = LOG_UART_BUFFER_SIZE - m_fill_len;
+        if (count > len)
+        {
+            count = len;
+        }
+
+        memcpy(&m_buffer[m_fill][m_fill_len], str, count);
+        m_fill_len += count;
+        str += count;
+        len -= count;
+
+        if (len && in_isr && m_ready)
+        {
+            // Both buffers are full and an interrupt can't wait for the DMA
+            // interrupt, which may be masked.
+            _finish_polling();
+        }
+        _start_transfer();
+
+        _unlock(state);
+
+        if (len && !in_isr)
+        {
+            // Wait for DMA to finish sending the other buffer
+            if (osKernelRunning == osKernelGetState())
+            {
+                osDelay(1);
+            }
+            else if (!m_ready)
+            {
+                // Nothing can be sent yet
+                break;
+            }
+        }
+        else if (len && !m_ready)
+        {
+            break;
+        }
+    }
+}
+
+
+char *log_backend_reserve(size_t *p_size, uint32_t *p_state)
+{
+    _setup();
+
+    if (m_failed)
+    {
+        *p_size = 0;
+        return NULL;
+    }
+
+    *p_state = _lock();
+    *p_size = LOG_UART_BUFFER_SIZE - m_fill_len;
+    return (char *)&m_buffer[m_fill][m_fill_len];
+}
+
+
+void log_backend_commit(size_t length, uint32_t state)
+{
+    m_fill_len += length;
+    _start_transfer();
+    _unlock(state);
+}
+
+
+size_t log_backend_read(char *buffer, size_t size)
+{
+    // USART3 is only used for output
+    return 0;
+}
+
+
+void log_backend_flush(void)
+{
+    uint32_t state = _lock();
+
+    if (m_ready)
+    {
+        _finish_polling();
+        _start_transfer();
+        _finish_polling();
+    }
+    _unlock(state);
+}
+
+
+/**@brief   DMA1 stream 0 interrupt handler, replaces the weak definition in
+ *          the startup file.
+ */
+void DMA1_Stream0_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&m_hdma_tx);
+}
+
+
+/**@brief   USART3 interrupt handler, replaces the weak definition in the
+ *          startup file.
+ */
+void USART3_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&huart3);
+}
+
+
+/**@brief   Called by the HAL when the last byte of a transfer has been sent.
+ *
+ * @param   huart[in]   The UART that finished the transfer.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (&huart3 == huart)
+    {
+        m_busy = false;
+        _start_transfer();
+    }
+}
+
+#endif  // LOG_BACKEND_UART
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
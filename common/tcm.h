@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * File Name          : tcm.h
+  * Description        : This file provides the attributes that place code and
+  *                      data in the tightly coupled memories of the core.
+  *
+  * The ITCM (64 KiB) and the DTCM (128 KiB) are accessed by the core without
+  * wait states and aren't cached, so the timing of what runs from them
+  * doesn't depend on the state of the caches.  The startup code copies the
+  * code and the initialized data from FLASH and clears the rest, see
+  * STM32H723ZGTX_FLASH.ld.
+  *
+  * Besides what uses these attributes, the linker script places in the TCMs
+  * the context switch, tick and list functions of FreeRTOS, the heap of
+  * FreeRTOS, so the stacks of the tasks, and the main stack used by the
+  * interrupts.  With ITCM_PROFILE set, the hottest functions of a profile
+  * also go to the ITCM, see tools/itcm_placement.py.
+  *
+  * DMA1 and DMA2 can't access the TCMs, a DMA buffer must not be FAST_DATA
+  * or FAST_BSS, or allocated from the heap of FreeRTOS.
+  *
+  * The host build has no TCM, the attributes do nothing.
+  */
+
+#ifndef __X_TCM_H
+#define __X_TCM_H
+
+#if !defined(BUILD_UT)
+
+/**@brief   Run a function from the ITCM.
+ *
+ * A call between the ITCM and FLASH goes through a veneer added by the
+ * linker, so RAMFUNC is for functions whose hot loop calls little else.
+ * The function isn't inlined, which would put its code back in FLASH.
+ */
+#define RAMFUNC                 __attribute__((section(".itcm_text"), noinline))
+
+/**@brief   Place an initialized variable in the DTCM.
+ */
+#define FAST_DATA               __attribute__((section(".dtcm_data")))
+
+/**@brief   Place a variable in the DTCM, cleared at startup.
+ */
+#define FAST_BSS                __attribute__((section(".dtcm_bss")))
+
+#else
+
+#define RAMFUNC
+#define FAST_DATA
+#define FAST_BSS
+
+#endif  // !defined(BUILD_UT)
+
+#endif  // __X_TCM_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -75,6 +75,10 @@ def main():
     make_all = False
     is_debug = False
     is_debug_pins = False
+    is_cm4f = False
+    is_benchmark = False
+    opt_profile = "size"
+    is_lto = False
 
     # String of any CMake options set directly by command line args
     options = ""
@@ -94,11 +98,42 @@ def main():
         if arg == "debug_pins":
             is_debug_pins = True
 
+        # Cortex-M4F build, to compare with the default Cortex-M7 build
+        if arg == "cm4f":
+            is_cm4f = True
+
+        # Run the log benchmarks at startup
+        if arg == "benchmark":
+            is_benchmark = True
+
+        # Optimization profiles, -O2 or -O3 instead of -Os
+        if arg in ("speed", "fast"):
+            opt_profile = arg
+
+        # Link time optimization
+        if arg == "lto":
+            is_lto = True
+
     if is_debug_pins:
         options = f"{options}-DDEBUG_PINS=ON "
     else:
         options = f"{options}-DDEBUG_PINS=OFF "
 
+    if is_cm4f:
+        options = f"{options}-DCPU_PROFILE=cm4f "
+    else:
+        options = f"{options}-DCPU_PROFILE=cm7 "
+
+    if is_benchmark:
+        options = f"{options}-DLOG_BENCHMARK=ON "
+
+    options = f"{options}-DOPT_PROFILE={opt_profile} "
+
+    if is_lto:
+        options = f"{options}-DLTO=ON "
+    else:
+        options = f"{options}-DLTO=OFF "
+
     if clean:
         if os.path.exists(BUILD_ROOT_PATH):
             run_command(f"{RMDIR_CMD} build{SEP}Arm")
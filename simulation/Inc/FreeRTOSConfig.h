@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * File Name          : FreeRTOSConfig.h
+  * Description        : This file adapts the FreeRTOS configuration of the
+  *                      target to the POSIX port of the simulation.
+  *
+  * The configuration of stm32cubemx/Core/Inc is included as is, only what
+  * the port or a 64-bit host needs is changed here.
+  */
+
+#ifndef __X_SIM_FREERTOS_CONFIG_H
+#define __X_SIM_FREERTOS_CONFIG_H
+
+#include <stdlib.h>
+
+#include_next "FreeRTOSConfig.h"
+
+// The pointers and the TCBs are twice as large
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE                    ((size_t)(256 * 1024))
+
+// The port has no SysTick, cmsis_os2.c must not define its handler
+#undef USE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION
+#define USE_CUSTOM_SYSTICK_HANDLER_IMPLEMENTATION 1
+
+// Stop in the debugger, or let valgrind print the stack
+#undef configASSERT
+#define configASSERT( x ) if ((x) == 0) { abort(); }
+
+#endif  // __X_SIM_FREERTOS_CONFIG_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
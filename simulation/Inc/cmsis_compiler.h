@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * File Name          : cmsis_compiler.h
+  * Description        : This file replaces the CMSIS compiler header for
+  *                      cmsis_os2.c in the simulation.
+  *
+  * The intrinsics of cmsis_gcc.h are Arm assembly, the ones of the host
+  * stm32h7xx.h are used instead.
+  */
+
+#ifndef __X_SIM_CMSIS_COMPILER_H
+#define __X_SIM_CMSIS_COMPILER_H
+
+#include "stm32h7xx.h"
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE         static inline
+#endif
+#ifndef __WEAK
+#define __WEAK                  __attribute__((weak))
+#endif
+#ifndef __NO_RETURN
+#define __NO_RETURN             __attribute__((__noreturn__))
+#endif
+
+#endif  // __X_SIM_CMSIS_COMPILER_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
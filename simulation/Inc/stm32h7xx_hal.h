@@ -0,0 +1,226 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32h7xx_hal.h
+  * Description        : This file adds the HAL API used by main.c to the host
+  *                      HAL of the common library.
+  *
+  * The types have the fields main.c sets and the functions only return
+  * HAL_OK, see sim_hal.c.  The GPIO functions are the ones of the host HAL.
+  */
+
+#ifndef __X_SIM_STM32H7XX_HAL_H
+#define __X_SIM_STM32H7XX_HAL_H
+
+#include_next "stm32h7xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+
+// ------------------------------------------------------------------------ PWR
+#define PWR_LDO_SUPPLY                  0x00000002U
+#define PWR_REGULATOR_VOLTAGE_SCALE0    0x00000000U
+#define PWR_FLAG_VOSRDY                 0x00000001U
+
+#define __HAL_PWR_VOLTAGESCALING_CONFIG(REGULATOR)  ((void)(REGULATOR))
+#define __HAL_PWR_GET_FLAG(FLAG)                    (1U)
+
+HAL_StatusTypeDef HAL_PWREx_ConfigSupply(uint32_t SupplySource);
+
+// ------------------------------------------------------------------------ RCC
+typedef struct
+{
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLM;
+    uint32_t PLLN;
+    uint32_t PLLP;
+    uint32_t PLLQ;
+    uint32_t PLLR;
+    uint32_t PLLRGE;
+    uint32_t PLLVCOSEL;
+    uint32_t PLLFRACN;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t SYSCLKDivider;
+    uint32_t AHBCLKDivider;
+    uint32_t APB3CLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+    uint32_t APB4CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSE          0x00000001U
+#define RCC_HSE_BYPASS                  0x00000002U
+#define RCC_PLL_ON                      0x00000002U
+#define RCC_PLLSOURCE_HSE               0x00000002U
+#define RCC_PLL1VCIRANGE_1              0x00000004U
+#define RCC_PLL1VCOWIDE                 0x00000000U
+#define RCC_CLOCKTYPE_SYSCLK            0x00000001U
+#define RCC_CLOCKTYPE_HCLK              0x00000002U
+#define RCC_CLOCKTYPE_D1PCLK1           0x00000004U
+#define RCC_CLOCKTYPE_PCLK1             0x00000008U
+#define RCC_CLOCKTYPE_PCLK2             0x00000010U
+#define RCC_CLOCKTYPE_D3PCLK1           0x00000020U
+#define RCC_SYSCLKSOURCE_PLLCLK         0x00000003U
+#define RCC_SYSCLK_DIV1                 0x00000000U
+#define RCC_HCLK_DIV2                   0x00000008U
+#define RCC_APB1_DIV2                   0x00000040U
+#define RCC_APB2_DIV2                   0x00000400U
+#define RCC_APB3_DIV2                   0x00000040U
+#define RCC_APB4_DIV2                   0x00000040U
+#define FLASH_LATENCY_3                 0x00000003U
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOE_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOF_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOG_CLK_ENABLE()    do {} while (0)
+#define __HAL_RCC_GPIOH_CLK_ENABLE()    do {} while (0)
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+
+// -------------------------------------------------------------------- OCTOSPI
+typedef struct
+{
+    uint32_t FifoThreshold;
+    uint32_t DualQuad;
+    uint32_t MemoryType;
+    uint32_t DeviceSize;
+    uint32_t ChipSelectHighTime;
+    uint32_t FreeRunningClock;
+    uint32_t ClockMode;
+    uint32_t WrapSize;
+    uint32_t ClockPrescaler;
+    uint32_t SampleShifting;
+    uint32_t DelayHoldQuarterCycle;
+    uint32_t ChipSelectBoundary;
+    uint32_t ClkChipSelectHighTime;
+    uint32_t DelayBlockBypass;
+    uint32_t MaxTran;
+    uint32_t Refresh;
+} OSPI_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    OSPI_InitTypeDef Init;
+} OSPI_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t ClkPort;
+    uint32_t DQSPort;
+    uint32_t NCSPort;
+    uint32_t IOLowPort;
+    uint32_t IOHighPort;
+} OSPIM_CfgTypeDef;
+
+extern uint32_t sim_octospi1;
+
+#define OCTOSPI1                        ((void *)&sim_octospi1)
+
+#define HAL_OSPI_DUALQUAD_DISABLE       0x00000000U
+#define HAL_OSPI_MEMTYPE_MICRON         0x00000000U
+#define HAL_OSPI_FREERUNCLK_DISABLE     0x00000000U
+#define HAL_OSPI_CLOCK_MODE_0           0x00000000U
+#define HAL_OSPI_WRAP_NOT_SUPPORTED     0x00000000U
+#define HAL_OSPI_SAMPLE_SHIFTING_NONE   0x00000000U
+#define HAL_OSPI_DHQC_DISABLE           0x00000000U
+#define HAL_OSPI_DELAY_BLOCK_BYPASSED   0x00000001U
+#define HAL_OSPIM_IOPORT_1_LOW          0x00000001U
+#define HAL_OSPIM_IOPORT_1_HIGH         0x00010001U
+#define HAL_OSPI_TIMEOUT_DEFAULT_VALUE  5000U
+
+HAL_StatusTypeDef HAL_OSPI_Init(OSPI_HandleTypeDef *hospi);
+HAL_StatusTypeDef HAL_OSPIM_Config(OSPI_HandleTypeDef *hospi, OSPIM_CfgTypeDef *cfg, uint32_t Timeout);
+
+// ----------------------------------------------------------------------- UART
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+    uint32_t OneBitSampling;
+    uint32_t ClockPrescaler;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    uint32_t AdvFeatureInit;
+} UART_AdvFeatureInitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    UART_InitTypeDef Init;
+    UART_AdvFeatureInitTypeDef AdvancedInit;
+} UART_HandleTypeDef;
+
+extern uint32_t sim_usart3;
+
+#define USART3                          ((void *)&sim_usart3)
+
+#define UART_WORDLENGTH_8B              0x00000000U
+#define UART_STOPBITS_1                 0x00000000U
+#define UART_PARITY_NONE                0x00000000U
+#define UART_MODE_TX_RX                 0x0000000CU
+#define UART_HWCONTROL_NONE             0x00000000U
+#define UART_OVERSAMPLING_16            0x00000000U
+#define UART_ONE_BIT_SAMPLE_DISABLE     0x00000000U
+#define UART_PRESCALER_DIV1             0x00000000U
+#define UART_ADVFEATURE_NO_INIT         0x00000000U
+#define UART_TXFIFO_THRESHOLD_1_8       0x00000000U
+#define UART_RXFIFO_THRESHOLD_1_8       0x00000000U
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UARTEx_SetTxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold);
+HAL_StatusTypeDef HAL_UARTEx_SetRxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold);
+HAL_StatusTypeDef HAL_UARTEx_DisableFifoMode(UART_HandleTypeDef *huart);
+
+// ------------------------------------------------------------------------ TIM
+typedef struct
+{
+    void *Instance;
+} TIM_HandleTypeDef;
+
+extern uint32_t sim_tim6;
+
+#define TIM6                            ((void *)&sim_tim6)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __X_SIM_STM32H7XX_HAL_H
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * File Name          : sim_hal.c
+  * Description        : This file implements the HAL functions called by
+  *                      main.c in the simulation.
+  *
+  * There's no hardware, every function succeeds without doing anything.
+  */
+
+#include "stm32h7xx_hal.h"
+
+uint32_t sim_octospi1;
+uint32_t sim_usart3;
+uint32_t sim_tim6;
+
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    return HAL_OK;
+}
+
+
+void HAL_IncTick(void)
+{
+    // HAL_GetTick() reads the monotonic clock
+}
+
+
+HAL_StatusTypeDef HAL_PWREx_ConfigSupply(uint32_t SupplySource)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_OSPI_Init(OSPI_HandleTypeDef *hospi)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_OSPIM_Config(OSPI_HandleTypeDef *hospi, OSPIM_CfgTypeDef *cfg, uint32_t Timeout)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UARTEx_SetTxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UARTEx_SetRxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold)
+{
+    return HAL_OK;
+}
+
+
+HAL_StatusTypeDef HAL_UARTEx_DisableFifoMode(UART_HandleTypeDef *huart)
+{
+    return HAL_OK;
+}
+
+/* vim: set tabstop=8 expandtab shiftwidth=4 softtabstop=4 : */
@@ -29,6 +29,7 @@
 
 #include "log.h"
 
+#include "cache.h"
 #include "debug.h"
 /* USER CODE END Includes */
 
@@ -86,6 +87,8 @@ void StartDefaultTask(void *argument);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+  // Set the cacheability of the DMA and RTT memory before it's used
+  cache_init();
 
   /* USER CODE END 1 */
 
@@ -436,6 +439,8 @@ void Error_Handler(void)
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
   __disable_irq();
+  LOG_CRITICAL("Error_Handler called\n");
+  log_dump();
   while (1)
   {
   }
@@ -23,6 +23,12 @@
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+
+#define LOG_MODULE_NAME         fault
+#define LOG_LEVEL               LOG_LEVEL_DEBUG
+
+#include "log.h"
+
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -86,7 +92,8 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  LOG_CRITICAL("HardFault: CFSR 0x%08lx HFSR 0x%08lx\n", SCB->CFSR, SCB->HFSR);
+  log_dump();
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -101,7 +108,8 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  LOG_CRITICAL("MemManage: CFSR 0x%08lx HFSR 0x%08lx\n", SCB->CFSR, SCB->HFSR);
+  log_dump();
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -116,7 +124,8 @@ void MemManage_Handler(void)
 void BusFault_Handler(void)
 {
   /* USER CODE BEGIN BusFault_IRQn 0 */
-
+  LOG_CRITICAL("BusFault: CFSR 0x%08lx HFSR 0x%08lx\n", SCB->CFSR, SCB->HFSR);
+  log_dump();
   /* USER CODE END BusFault_IRQn 0 */
   while (1)
   {
@@ -131,7 +140,8 @@ void BusFault_Handler(void)
 void UsageFault_Handler(void)
 {
   /* USER CODE BEGIN UsageFault_IRQn 0 */
-
+  LOG_CRITICAL("UsageFault: CFSR 0x%08lx HFSR 0x%08lx\n", SCB->CFSR, SCB->HFSR);
+  log_dump();
   /* USER CODE END UsageFault_IRQn 0 */
   while (1)
   {
@@ -0,0 +1,64 @@
+#!/bin/bash
+
+# Build the application with every optimization profile, with and without
+# LTO, and print the memory used by each next to the one of the size profile.
+#
+# The builds have LOG_BENCHMARK enabled, so the cycle counts of each profile
+# are printed by the log benchmarks at startup.  Flash the hex file of a
+# build and read them on the RTT terminal, e.g.:
+#
+#   tools/flash.sh -j -r -f build/Profiles/fast-lto/application/application.hex
+
+# --------------------------------- Get the directory that this script lives in
+SCRIPT_WORKING_DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+PROJECT_DIR=${SCRIPT_WORKING_DIR}/..
+BUILD_DIR=${PROJECT_DIR}/build/Profiles
+TOOLCHAIN_FILE=${PROJECT_DIR}/toolchain/arm_embedded_toolchain.txt
+
+
+# ------------------------------------------------------------ Build each one
+# The sizes are read from the report the size_report target writes for each
+# build, see tools/size_report.py, so no binutils are needed on the PATH.
+NAMES=()
+
+for profile in size speed fast; do
+    for lto in OFF ON; do
+        name=${profile}
+        [[ ${lto} == ON ]] && name=${profile}-lto
+
+        cmake -S ${PROJECT_DIR} -B ${BUILD_DIR}/${name} \
+            -G "Unix Makefiles" \
+            -DCMAKE_TOOLCHAIN_FILE:PATH=${TOOLCHAIN_FILE} \
+            -DCMAKE_BUILD_TYPE=Release \
+            -DLOG_BENCHMARK=ON \
+            -DOPT_PROFILE=${profile} \
+            -DLTO=${lto} > /dev/null || exit 1
+
+        cmake --build ${BUILD_DIR}/${name} -j"$(nproc)" > /dev/null || exit 1
+
+        NAMES+=(${name})
+    done
+done
+
+
+# ------------------------------------------------------------ Print the sizes
+# The bytes used in each memory region, and the FLASH delta against the size
+# profile
+python3 - ${BUILD_DIR} "${NAMES[@]}" <<'PYTHON'
+import json
+import sys
+
+build_dir, names = sys.argv[1], sys.argv[2:]
+reports = {}
+for name in names:
+    with open(f"{build_dir}/{name}/application/application.size.json", encoding="utf-8") as file:
+        reports[name] = json.load(file)["regions"]
+
+regions = sorted({r for report in reports.values() for r in report})
+print()
+print(f"{'profile':<12}" + "".join(f" {r:>10}" for r in regions) + f" {'FLASH delta':>12}")
+for name in names:
+    used = {r: reports[name].get(r, {}).get("used", 0) for r in regions}
+    delta = used.get("FLASH", 0) - reports[names[0]].get("FLASH", {}).get("used", 0)
+    print(f"{name:<12}" + "".join(f" {used[r]:>10}" for r in regions) + f" {delta:>+12}")
+PYTHON
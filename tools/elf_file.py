@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Minimal ELF file reader used by the host tools.
+
+Only the parts needed by the tools are parsed: the section headers and the
+symbol table.  Both 32 and 64 bit, little and big endian files are supported
+so that the tools can be tried on host binaries as well as application.elf.
+"""
+
+import struct
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+
+STT_FUNC = 2
+
+
+class Section:
+    """
+    A section header and its contents
+    """
+    def __init__(self, name, sh_type, flags, addr, offset, size, link, entsize):
+        self.name = name
+        self.type = sh_type
+        self.flags = flags
+        self.addr = addr
+        self.offset = offset
+        self.size = size
+        self.link = link
+        self.entsize = entsize
+        self.data = b""
+
+    def contains(self, addr):
+        """
+        Returns True if the address is inside the section
+        """
+        return self.addr <= addr < self.addr + self.size
+
+
+class Symbol:
+    """
+    An entry of the symbol table
+    """
+    def __init__(self, name, value, size, sym_type, shndx):
+        self.name = name
+        self.value = value
+        self.size = size
+        self.type = sym_type
+        self.shndx = shndx
+
+
+class ElfFile:
+    """
+    Parses an ELF file into a list of sections and symbols
+    """
+    def __init__(self, path):
+        with open(path, "rb") as file:
+            self.raw = file.read()
+
+        if self.raw[:4] != b"\x7fELF":
+            raise ValueError(f"{path} is not an ELF file")
+
+        self.is_64 = self.raw[4] == 2
+        self.endian = "<" if self.raw[5] == 1 else ">"
+
+        self.sections = self._parse_sections()
+        self.symbols = self._parse_symbols()
+
+    def _unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.raw, offset)
+
+    def _parse_sections(self):
+        if self.is_64:
+            shoff, = self._unpack("Q", 0x28)
+            shentsize, shnum, shstrndx = self._unpack("HHH", 0x3A)
+            header_fmt = "IIQQQQIIQQ"
+        else:
+            shoff, = self._unpack("I", 0x20)
+            shentsize, shnum, shstrndx = self._unpack("HHH", 0x2E)
+            header_fmt = "IIIIIIIIII"
+
+        headers = []
+        for i in range(shnum):
+            headers.append(self._unpack(header_fmt, shoff + i * shentsize))
+
+        names_offset = headers[shstrndx][4] if shnum else 0
+
+        sections = []
+        for (name, sh_type, flags, addr, offset, size, link, _, _, entsize) in headers:
+            section = Section(
+                self._string(names_offset + name), sh_type, flags, addr,
+                offset, size, link, entsize
+            )
+            if sh_type != SHT_NOBITS:
+                section.data = self.raw[offset:offset + size]
+            sections.append(section)
+
+        return sections
+
+    def _string(self, offset):
+        end = self.raw.index(b"\0", offset)
+        return self.raw[offset:end].decode("utf-8", "replace")
+
+    def _parse_symbols(self):
+        symbols = []
+
+        for section in self.sections:
+            if section.type != SHT_SYMTAB:
+                continue
+
+            names = self.sections[section.link].offset
+            for offset in range(0, section.size, section.entsize):
+                if self.is_64:
+                    name, info, _, shndx, value, size = self._unpack(
+                        "IBBHQQ", section.offset + offset)
+                else:
+                    name, value, size, info, _, shndx = self._unpack(
+                        "IIIBBH", section.offset + offset)
+
+                symbols.append(
+                    Symbol(self._string(names + name), value, size, info & 0xF, shndx))
+
+        return symbols
+
+    def section(self, name):
+        """
+        Returns the section with the given name or None
+        """
+        for section in self.sections:
+            if section.name == name:
+                return section
+        return None
+
+    def read(self, addr, size):
+        """
+        Read bytes from a loaded section at the given address, None if the
+        address isn't in a section with contents
+        """
+        for section in self.sections:
+            if (section.flags & SHF_ALLOC) and section.type != SHT_NOBITS \
+                    and section.contains(addr):
+                start = addr - section.addr
+                return section.data[start:start + size]
+        return None
+
+    def read_string(self, addr, section=None):
+        """
+        Read a NULL terminated string at the given address, None if the address
+        isn't in a section with contents
+        """
+        if section is None:
+            data = self.read(addr, 1 << 16)
+        elif section.contains(addr):
+            data = section.data[addr - section.addr:]
+        else:
+            data = None
+
+        if data is None:
+            return None
+
+        end = data.find(b"\0")
+        if end >= 0:
+            data = data[:end]
+        return data.decode("utf-8", "replace")
+
+    def functions(self):
+        """
+        Returns the function symbols that have a size
+        """
+        return [s for s in self.symbols if s.type == STT_FUNC and s.size]
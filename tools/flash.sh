@@ -216,8 +216,10 @@ rtt_jlink() {
             args="-SelectEmuBySN ${serial_number} ${args}"
         fi
 
-        # Commands to send to the J-Link to reset and start running
-        commands="r
+        # Commands to send to the J-Link to reset and start running.  The RTT
+        # control block is in RAM_D2, which isn't searched by default.
+        commands="exec SetRTTSearchRanges 0x30000000 0x8000
+            r
             g"
 
         echo "${commands}" | JLinkExe ${args} &
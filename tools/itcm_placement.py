@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+Choose the functions to run from the ITCM from a profile of the firmware.
+
+The tool reads how often each function runs, the size of each function from
+the object files of the build, and writes a linker script fragment listing
+the functions that give the most samples per byte of ITCM, up to the space
+left in the ITCM.  The .itcm_text section of STM32H723ZGTX_FLASH.ld includes
+the fragment, itcm_hot.ld, and the build regenerates it before every link of
+application.elf when ITCM_PROFILE is set.  The placement then follows the
+code as it changes, as long as the profile is taken again from time to time.
+
+Two kinds of profile are read:
+
+  --pc FILE --elf ELF
+      Program counter samples of the target, e.g. the DWT PCSR register read
+      by the debugger or the PC sampling packets of the SWO, one hex address
+      per line.  ELF is the application.elf the samples were taken with, keep
+      a copy since the build overwrites it.
+
+  --counts FILE
+      Lines with a count or percentage first and a function name last, such
+      as the output of "perf report --stdio --sort symbol" on the simulation
+      build, or a gprof flat profile.  The host runs the same common and
+      kernel code, not the same HAL and port.
+
+The functions already placed by the linker script, by name or with RAMFUNC,
+count against the ITCM but aren't listed again.  Functions that aren't in
+the objects of the build, e.g. the ones of the C library, can't be placed.
+The objects need a .text.<function> section per function, so LTO builds
+are rejected: the tool fails when it finds none.
+
+Examples:
+
+    # From the simulation
+    perf record -o sim.perf build/Host/simulation/simulation
+    perf report -i sim.perf --stdio --sort symbol > sim.counts
+    cmake -DITCM_PROFILE=sim.counts ...
+
+    # By hand, from a PC capture
+    itcm_placement.py --pc pcs.txt --elf application.elf \\
+        --objects build/Arm --ld stm32cubemx/STM32H723ZGTX_FLASH.ld \\
+        --output build/Arm/itcm_hot.ld
+"""
+
+import argparse
+import bisect
+import os
+import re
+import sys
+
+from elf_file import ElfFile
+
+# Size of the ITCM and the unused bytes at its start, see the linker script
+ITCM_SIZE = 64 * 1024
+ITCM_RESERVED = 32
+
+# Space kept for the alignment of the functions and the veneers the linker
+# adds to the calls between the ITCM and FLASH
+DEFAULT_MARGIN = 2048
+
+TEXT_PREFIX = ".text."
+ITCM_SECTION = ".itcm_text"
+
+# Run by the startup code before the ITCM is loaded
+NEVER_PLACED = {"Reset_Handler", "SystemInit", "Default_Handler"}
+
+# Input sections already placed by the linker script
+PLACED_SECTION = re.compile(r"\*\(\.text\.([A-Za-z0-9_$.]+)\)")
+
+
+def read_pc_profile(path, elf_path):
+    """
+    Returns { function: samples } from a file of PC samples
+    """
+    elf = ElfFile(elf_path)
+
+    # Clear the Thumb bit of the function addresses
+    functions = sorted((s.value & ~1, s.size, s.name) for s in elf.functions())
+    starts = [f[0] for f in functions]
+
+    counts = {}
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+
+            pc = int(line.split()[0], 16)
+            index = bisect.bisect_right(starts, pc) - 1
+            if index >= 0:
+                start, size, name = functions[index]
+                if pc < start + size:
+                    counts[name] = counts.get(name, 0) + 1
+
+    return counts
+
+
+def read_counts_profile(path):
+    """
+    Returns { function: count } from a file of counts and names
+    """
+    counts = {}
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            fields = line.split()
+            if not fields or fields[0].startswith("#"):
+                continue
+
+            try:
+                count = float(fields[0].rstrip("%"))
+            except ValueError:
+                continue
+
+            name = fields[-1]
+            counts[name] = counts.get(name, 0) + count
+
+    return counts
+
+
+def read_sizes(directories):
+    """
+    Returns ({ function: bytes }, bytes of the ITCM sections) from the object
+    files found under the directories
+    """
+    sizes = {}
+    itcm = 0
+
+    for directory in directories:
+        for root, _, files in os.walk(directory):
+            for name in files:
+                if not name.endswith((".o", ".obj")):
+                    continue
+
+                try:
+                    elf = ElfFile(os.path.join(root, name))
+                except ValueError:
+                    continue
+
+                for section in elf.sections:
+                    if section.name.startswith(TEXT_PREFIX):
+                        function = section.name[len(TEXT_PREFIX):]
+                        sizes[function] = sizes.get(function, 0) + section.size
+                    elif section.name.startswith(ITCM_SECTION):
+                        itcm += section.size
+
+    return sizes, itcm
+
+
+def read_placed(path):
+    """
+    Returns the names of the functions placed in the ITCM by the linker script
+    """
+    if path is None:
+        return set()
+
+    with open(path, encoding="utf-8") as file:
+        return set(PLACED_SECTION.findall(file.read()))
+
+
+def choose(counts, sizes, placed, budget):
+    """
+    Returns the functions to place, the most samples per byte first
+    """
+    candidates = []
+    for name, count in counts.items():
+        size = sizes.get(name)
+        if count <= 0 or not size or name in placed or name in NEVER_PLACED:
+            continue
+        candidates.append((count / size, name, count, size))
+
+    candidates.sort(key=lambda c: (-c[0], c[1]))
+
+    chosen = []
+    for _, name, count, size in candidates:
+        # Each function is aligned on at least a word
+        size = (size + 3) & ~3
+        if size <= budget:
+            chosen.append((name, count, size))
+            budget -= size
+
+    return chosen
+
+
+def write_fragment(path, chosen, profile, share):
+    """
+    Write the linker script fragment
+    """
+    with open(path, "w", encoding="utf-8") as file:
+        file.write(f"/* Generated by tools/itcm_placement.py from {os.path.basename(profile)},\n")
+        file.write(f"   don't edit.  {len(chosen)} functions, "
+                   f"{sum(c[2] for c in chosen)} bytes, {share:.1f}% of the profile. */\n")
+        for name, _, _ in chosen:
+            file.write(f"*(.text.{name})\n")
+
+
+def main():
+    """
+    Program entry point
+    """
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--pc", metavar="FILE", help="PC samples, one hex address per line")
+    source.add_argument("--counts", metavar="FILE", help="counts or percentages and names")
+    parser.add_argument("--elf", help="application.elf the PC samples were taken with")
+    parser.add_argument("--objects", metavar="DIR", action="append", required=True,
+                        help="directory searched for the object files, may be repeated")
+    parser.add_argument("--ld", metavar="FILE",
+                        help="linker script, for the functions it already places")
+    parser.add_argument("--margin", type=int, default=DEFAULT_MARGIN,
+                        help=f"bytes kept for alignment and veneers (default {DEFAULT_MARGIN})")
+    parser.add_argument("--output", metavar="FILE", required=True,
+                        help="linker script fragment to write")
+    args = parser.parse_args()
+
+    if args.pc:
+        if not args.elf:
+            parser.error("--pc needs --elf")
+        profile = args.pc
+        counts = read_pc_profile(args.pc, args.elf)
+    else:
+        profile = args.counts
+        counts = read_counts_profile(args.counts)
+
+    sizes, itcm = read_sizes(args.objects)
+    if not sizes:
+        # LTO objects only hold the intermediate code, the sections of the
+        # functions are made by the link
+        print(f"[itcm_placement] no {TEXT_PREFIX}<function> section in the objects under "
+              f"{', '.join(args.objects)}, built with LTO or without -ffunction-sections?",
+              file=sys.stderr)
+        return 1
+
+    if counts and not any(name in sizes for name in counts):
+        print(f"[itcm_placement] warning: none of the {len(counts)} functions of "
+              f"{profile} is in the objects, is the profile from this build?",
+              file=sys.stderr)
+
+    placed = read_placed(args.ld)
+    itcm += sum(sizes.get(name, 0) for name in placed)
+
+    budget = ITCM_SIZE - ITCM_RESERVED - args.margin - itcm
+    if budget < 0:
+        print(f"[itcm_placement] the ITCM is already full by {-budget} bytes",
+              file=sys.stderr)
+        budget = 0
+
+    chosen = choose(counts, sizes, placed, budget)
+
+    total = sum(counts.values())
+    share = 100.0 * sum(c[1] for c in chosen) / total if total else 0.0
+    write_fragment(args.output, chosen, profile, share)
+
+    print(f"[itcm_placement] {itcm} bytes already placed, {budget} bytes available")
+    print(f"{'count':>12} {'bytes':>7}  function")
+    for name, count, size in chosen:
+        print(f"{count:>12g} {size:>7}  {name}")
+    print(f"[itcm_placement] {len(chosen)} functions, "
+          f"{sum(c[2] for c in chosen)} bytes, {share:.1f}% of the profile")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
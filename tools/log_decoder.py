@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+"""
+Decode a dictionary log stream captured from the RTT terminal channel.
+
+When the firmware is built with LOG_DICTIONARY the log task writes binary
+frames holding string IDs and raw argument words instead of text.  The format
+strings and module names only exist in the .log_str section of
+application.elf, so this tool needs the ELF file, or a dictionary exported
+from it with --export, to turn the frames back into log lines.
+
+Examples:
+
+    # Capture the stream, e.g. with JLinkRTTLogger, then decode it
+    log_decoder.py --elf build/Arm/application/application.elf capture.bin
+
+    # Export a dictionary next to the ELF file and decode with it later
+    log_decoder.py --elf application.elf --export application.logdict.json
+    log_decoder.py --dict application.logdict.json capture.bin
+
+    # Check the decoder itself, e.g. after changing the frame layout
+    log_decoder.py --self-test
+"""
+
+import argparse
+import json
+import re
+import sys
+
+from elf_file import ElfFile
+
+# Frame layout, see LOG_FRAME_* in common/log.c
+FRAME_FORMAT = ord("F")
+FRAME_TEXT = ord("T")
+FRAME_HEX = ord("H")
+FRAME_HEADER = 3
+
+FRAME_RAW = 0x10
+FRAME_TIMESTAMP = 0x20
+FRAME_FILE_LINE = 0x40
+FRAME_LEVEL_MASK = 0x0F
+FRAME_NO_LEVEL = 0x0F
+
+# Bytes before the description of a hex frame, see LOG_FRAME_HEX_HEADER
+HEX_HEADER = 10
+
+STRING_SECTION = ".log_str"
+
+# Must match m_level_str in common/log.c
+LEVELS = ["Debug", "Info", "Warn", "Error", "Critical", "Test", "Unknown"]
+
+FORMAT_SPEC = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<precision>\*|\d*))?"
+    r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conversion>[diouxXcspfFeEgGaA%])"
+)
+
+
+class Dictionary:
+    """
+    Resolves string IDs and string arguments
+    """
+    def __init__(self, strings, memory):
+        # { address: string } of the .log_str section
+        self.strings = strings
+        # [ (address, bytes) ] of the loaded read-only data
+        self.memory = memory
+
+    @classmethod
+    def from_elf(cls, path):
+        """
+        Build the dictionary from the ELF file
+        """
+        elf = ElfFile(path)
+
+        strings = {}
+        section = elf.section(STRING_SECTION)
+        if section is not None:
+            start = 0
+            for index, value in enumerate(section.data):
+                if value == 0:
+                    if index > start:
+                        text = section.data[start:index].decode("utf-8", "replace")
+                        strings[section.addr + start] = text
+                    start = index + 1
+
+        memory = []
+        for section in elf.sections:
+            if section.name.startswith(".rodata") and section.data:
+                memory.append((section.addr, section.data))
+
+        return cls(strings, memory)
+
+    @classmethod
+    def from_json(cls, path):
+        """
+        Load a dictionary written by export()
+        """
+        with open(path, "r", encoding="utf-8") as file:
+            content = json.load(file)
+
+        strings = {int(k, 0): v for k, v in content["strings"].items()}
+        memory = [(int(m["address"], 0), bytes.fromhex(m["data"]))
+                  for m in content["memory"]]
+        return cls(strings, memory)
+
+    def export(self, path):
+        """
+        Write the dictionary to a JSON file
+        """
+        content = {
+            "strings": {f"0x{k:08x}": v for k, v in sorted(self.strings.items())},
+            "memory": [{"address": f"0x{a:08x}", "data": d.hex()} for a, d in self.memory],
+        }
+        with open(path, "w", encoding="utf-8") as file:
+            json.dump(content, file, indent=1)
+
+    def string(self, string_id):
+        """
+        Returns the string with the given ID
+        """
+        if string_id == 0:
+            return ""
+
+        if string_id in self.strings:
+            return self.strings[string_id]
+
+        # The ID may point into the middle of a string that was merged
+        for start in sorted(self.strings, reverse=True):
+            if start < string_id < start + len(self.strings[start]):
+                return self.strings[start][string_id - start:]
+
+        # Firmware that passed the name as a plain literal left it in .rodata
+        for start, data in self.memory:
+            if start <= string_id < start + len(data):
+                return self.pointer_string(string_id)
+
+        return f"<unknown string 0x{string_id:08x}>"
+
+    def pointer_string(self, addr):
+        """
+        Returns the string a %s argument points to
+        """
+        for start, data in self.memory:
+            if start <= addr < start + len(data):
+                data = data[addr - start:]
+                end = data.find(b"\0")
+                return data[:end if end >= 0 else len(data)].decode("utf-8", "replace")
+
+        return f"<str@0x{addr:08x}>"
+
+
+def to_signed(value, bits):
+    """
+    Interpret an unsigned value as a two's complement number
+    """
+    value &= (1 << bits) - 1
+    if value & (1 << (bits - 1)):
+        value -= 1 << bits
+    return value
+
+
+def format_message(fmt, args, dictionary):
+    """
+    Apply a printf format string to a list of 32-bit argument words
+    """
+    args = list(args)
+    output = []
+    position = 0
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    for match in FORMAT_SPEC.finditer(fmt):
+        output.append(fmt[position:match.start()])
+        position = match.end()
+
+        conversion = match.group("conversion")
+        if conversion == "%":
+            output.append("%")
+            continue
+
+        flags = match.group("flags")
+        width = match.group("width") or ""
+        precision = match.group("precision")
+        length = match.group("length") or ""
+
+        if width == "*":
+            width = str(to_signed(next_arg(), 32))
+        if precision == "*":
+            precision = str(max(to_signed(next_arg(), 32), 0))
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+
+        value = next_arg()
+        bits = {"hh": 8, "h": 16}.get(length, 32)
+
+        if conversion in "di":
+            output.append((spec + "d") % to_signed(value, bits))
+        elif conversion in "ouxX":
+            output.append((spec + conversion) % (value & ((1 << bits) - 1)))
+        elif conversion == "c":
+            output.append((spec + "c") % chr(value & 0xFF))
+        elif conversion == "s":
+            output.append((spec + "s") % dictionary.pointer_string(value))
+        elif conversion == "p":
+            output.append((spec + "s") % f"0x{value:x}")
+        else:
+            output.append(f"<%{conversion} unsupported>")
+
+    output.append(fmt[position:])
+    return "".join(output)
+
+
+def hex_line(data):
+    """
+    Format a line of a hex dump like _hex_encode() in common/log.c
+    """
+    text = []
+    for index, value in enumerate(data):
+        text.append(f"{value:02x} ")
+        if index % 4 == 3:
+            text.append(" ")
+    return "".join(text) + "\n"
+
+
+def hex_lines(payload, state):
+    """
+    Format the lines of a hex frame.
+
+    A dump is split into frames of whole lines.  state holds the offset the
+    next frame of the dump should start at, a gap means the middle of a large
+    area wasn't sent.
+    """
+    total = int.from_bytes(payload[0:4], "little")
+    position = int.from_bytes(payload[4:8], "little")
+    stride = max(payload[8], 1)
+    name_length = payload[9]
+    name = payload[HEX_HEADER:HEX_HEADER + name_length].decode("utf-8", "replace")
+    data = payload[HEX_HEADER + name_length:]
+
+    lines = []
+    if position == 0:
+        plural = "s" if total != 1 else ""
+        lines.append(f"{name} ({total} byte{plural})\n" if name
+                     else f"({total} byte{plural})\n")
+    elif position != state.get("next"):
+        lines.append("...\n")
+
+    for index in range(0, len(data), stride):
+        lines.append(hex_line(data[index:index + stride]))
+
+    state["next"] = position + len(data)
+    return lines
+
+
+def decode(data, dictionary, out):
+    """
+    Decode the frames in data and write the log lines to out.
+
+    Returns the number of bytes that were skipped because they weren't part of
+    a valid frame.
+    """
+    skipped = 0
+    offset = 0
+    hex_state = {}
+
+    while offset + FRAME_HEADER <= len(data):
+        frame_type, info, length = data[offset:offset + FRAME_HEADER]
+        payload = data[offset + FRAME_HEADER:offset + FRAME_HEADER + length]
+
+        if frame_type not in (FRAME_FORMAT, FRAME_TEXT, FRAME_HEX) or length < 4:
+            # Not the start of a frame, resynchronize on the next byte
+            offset += 1
+            skipped += 1
+            continue
+
+        if len(payload) < length:
+            # Truncated capture
+            break
+
+        offset += FRAME_HEADER + length
+
+        module = dictionary.string(int.from_bytes(payload[0:4], "little"))
+        payload = payload[4:]
+
+        timestamp = None
+        if info & FRAME_TIMESTAMP and len(payload) >= 8:
+            seconds = int.from_bytes(payload[0:4], "little")
+            micros = int.from_bytes(payload[4:8], "little")
+            timestamp = f"[{seconds}.{micros:06d}] "
+            payload = payload[8:]
+
+        file_line = None
+        if info & FRAME_FILE_LINE and len(payload) >= 8:
+            file_id = int.from_bytes(payload[0:4], "little")
+            line = int.from_bytes(payload[4:8], "little")
+            file_line = f"{dictionary.string(file_id)}:{line}: "
+            payload = payload[8:]
+
+        if frame_type == FRAME_FORMAT:
+            words = [int.from_bytes(payload[i:i + 4], "little")
+                     for i in range(0, len(payload) - 3, 4)]
+            lines = [format_message(dictionary.string(words[0]), words[1:], dictionary)
+                     if words else ""]
+        elif frame_type == FRAME_HEX:
+            if len(payload) < HEX_HEADER:
+                continue
+            lines = hex_lines(payload, hex_state)
+        else:
+            lines = [payload.decode("utf-8", "replace")]
+
+        prefix = ""
+        level = info & FRAME_LEVEL_MASK
+        if not (info & FRAME_RAW) and level != FRAME_NO_LEVEL:
+            level_str = LEVELS[min(level, len(LEVELS) - 1)]
+            prefix = f"{level_str}: {module}: " + (timestamp or "") + (file_line or "")
+
+        for text in lines:
+            out.write(prefix + text)
+
+    return skipped + (len(data) - offset)
+
+
+def self_test():
+    """
+    Decode synthetic frames and compare them with the expected log lines
+    """
+    strings = {0x90000000: "log_test", 0x90000010: "common/log_test.c",
+               0x90000030: "count %u\n"}
+    memory = [(0x08010000, b"old_module\0")]
+    dictionary = Dictionary(strings, memory)
+
+    def frame(frame_type, info, payload):
+        return bytes([frame_type, info, len(payload)]) + payload
+
+    def words(*values):
+        return b"".join(v.to_bytes(4, "little") for v in values)
+
+    data = b""
+    data += frame(FRAME_FORMAT, 1 | FRAME_FILE_LINE,
+                  words(0x90000000, 0x90000010, 12, 0x90000030, 7))
+    data += frame(FRAME_HEX, 0 | FRAME_FILE_LINE,
+                  words(0x90000000, 0x90000010, 34, 5, 0)
+                  + bytes([4, 3]) + b"buf" + bytes(range(5)))
+    data += frame(FRAME_HEX, 3, words(0x08010000, 2, 0) + bytes([8, 0]) + b"\xab\xcd")
+
+    expected = (
+        "Info: log_test: common/log_test.c:12: count 7\n"
+        "Debug: log_test: common/log_test.c:34: buf (5 bytes)\n"
+        "Debug: log_test: common/log_test.c:34: 00 01 02 03  \n"
+        "Debug: log_test: common/log_test.c:34: 04 \n"
+        "Error: old_module: (2 bytes)\n"
+        "Error: old_module: ab cd \n"
+    )
+
+    class Output:
+        def __init__(self):
+            self.text = []
+
+        def write(self, text):
+            self.text.append(text)
+
+    out = Output()
+    skipped = decode(data, dictionary, out)
+    text = "".join(out.text)
+    if skipped or text != expected:
+        print("log_decoder self test failed, got:\n" + text, file=sys.stderr)
+        return 1
+
+    print("log_decoder self test passed")
+    return 0
+
+
+def main():
+    """
+    Program entry point
+    """
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--elf", help="application.elf built with LOG_DICTIONARY")
+    source.add_argument("--dict", help="dictionary written with --export")
+    source.add_argument("--self-test", action="store_true",
+                        help="decode built-in frames and check the output")
+    parser.add_argument("--export", metavar="FILE",
+                        help="write the dictionary to FILE and exit")
+    parser.add_argument("capture", nargs="?", default="-",
+                        help="captured binary stream, - for stdin (default)")
+    args = parser.parse_args()
+
+    if args.self_test:
+        return self_test()
+
+    if args.elf:
+        dictionary = Dictionary.from_elf(args.elf)
+    else:
+        dictionary = Dictionary.from_json(args.dict)
+
+    if args.export:
+        dictionary.export(args.export)
+        return 0
+
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as file:
+            data = file.read()
+
+    skipped = decode(data, dictionary, sys.stdout)
+    if skipped:
+        print(f"\n[log_decoder] {skipped} bytes could not be decoded", file=sys.stderr)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+"""
+Report the memory used by application.elf, per region, section and module.
+
+The map file written by the linker gives the address and size of every input
+section and the object it comes from; the ELF file tells which output
+sections are loaded and which are only allocated (NOLOAD, .bss).  The code
+and the initialized data of the TCM and RAM sections count against the
+region they run from and against FLASH, where they are loaded from.
+
+The report is written as JSON, for tools, and as a text table sorted by name,
+so two reports can be compared with diff.  With --budget the tool fails when
+a region uses more than its budget, which makes the build fail.
+
+Examples:
+
+    size_report.py --map application.map --elf application.elf \\
+        --json application.size.json --text application.size.txt
+
+    # Fail if FLASH is over 512 KiB or RAM_D1 over 90% of its size
+    size_report.py --map application.map --elf application.elf \\
+        --budget FLASH=512K --budget RAM_D1=90%
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+from elf_file import ElfFile, SHF_ALLOC, SHT_NOBITS
+
+MEMORY_START = "Memory Configuration"
+MAP_START = "Linker script and memory map"
+
+REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_SECTION = re.compile(
+    r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$")
+OUTPUT_WRAPPED = re.compile(
+    r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+INPUT_SECTION = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*))?$")
+INPUT_WRAPPED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*)$")
+ARCHIVE_MEMBER = re.compile(r"(?:.*/)?lib([^/]+)\.a\((.+)\)$")
+
+FILL = "*fill*"
+FILL_MODULE = "(fill)"
+RESERVED_MODULE = "(reserved)"
+
+
+class Region:
+    """
+    A memory region of the linker script
+    """
+    def __init__(self, name, origin, length):
+        self.name = name
+        self.origin = origin
+        self.length = length
+        self.used = 0
+
+    def contains(self, addr):
+        """
+        Returns True if the address is inside the region
+        """
+        return self.origin <= addr < self.origin + self.length
+
+
+class OutputSection:
+    """
+    An output section and the size of its input sections per module
+    """
+    def __init__(self, name, addr, size, load):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.load = load
+        self.modules = {}
+
+    def add(self, module, size):
+        """
+        Add the size of an input section
+        """
+        self.modules[module] = self.modules.get(module, 0) + size
+
+
+def module_name(path):
+    """
+    Returns a short name for the object file of an input section
+    """
+    path = path.strip()
+    member = ARCHIVE_MEMBER.match(path)
+    if member:
+        library, name = member.groups()
+    else:
+        library = "application" if "application.elf.dir" in path else None
+        name = os.path.basename(path)
+
+    for suffix in (".obj", ".o"):
+        if name.endswith(suffix):
+            name = name[:-len(suffix)]
+            break
+
+    return f"{library}/{name}" if library else name
+
+
+def parse_map(path):
+    """
+    Returns the regions and the output sections of a map file
+    """
+    with open(path, encoding="utf-8", errors="replace") as file:
+        lines = file.read().splitlines()
+
+    regions = []
+    sections = []
+    index = 0
+
+    while index < len(lines) and lines[index].strip() != MEMORY_START:
+        index += 1
+
+    # The table of regions ends at the *default* region
+    while index < len(lines) and lines[index].strip() != MAP_START:
+        match = REGION.match(lines[index])
+        if match and not match.group(1).startswith("*"):
+            regions.append(Region(match.group(1), int(match.group(2), 16),
+                                  int(match.group(3), 16)))
+        index += 1
+
+    current = None
+    pending = None
+    while index < len(lines):
+        line = lines[index]
+        index += 1
+
+        match = OUTPUT_SECTION.match(line)
+        if match:
+            name, addr, size, load = match.groups()
+            if addr is None and index < len(lines):
+                wrapped = OUTPUT_WRAPPED.match(lines[index])
+                if wrapped:
+                    addr, size, load = wrapped.groups()
+                    index += 1
+            if addr is None:
+                current = None
+                continue
+
+            current = OutputSection(name, int(addr, 16), int(size, 16),
+                                    int(load, 16) if load else None)
+            sections.append(current)
+            pending = None
+            continue
+
+        if current is None or not line.startswith(" ") or line.startswith(" *("):
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if match and not line.startswith("  "):
+            name, _, size, source = match.groups()
+            if size is None:
+                # The name is too long, the address and size are on the
+                # next line
+                pending = name
+                continue
+            current.add(FILL_MODULE if name == FILL else module_name(source),
+                        int(size, 16))
+            pending = None
+            continue
+
+        match = INPUT_WRAPPED.match(line)
+        if match and pending is not None:
+            _, size, source = match.groups()
+            current.add(module_name(source), int(size, 16))
+            pending = None
+
+    return regions, sections
+
+
+def find_region(regions, addr):
+    """
+    Returns the region holding an address, or None
+    """
+    for region in regions:
+        if region.contains(addr):
+            return region
+    return None
+
+
+def parse_budget(text, regions):
+    """
+    Returns (region, bytes) from REGION=BYTES, REGION=<n>K, <n>M or <n>%
+    """
+    name, _, value = text.partition("=")
+    region = next((r for r in regions if r.name == name), None)
+    if region is None or not value:
+        raise ValueError(f"bad budget '{text}', regions are "
+                         + ", ".join(r.name for r in regions))
+
+    value = value.strip().upper()
+    if value.endswith("%"):
+        return region, int(region.length * float(value[:-1]) / 100)
+    if value.endswith("K"):
+        return region, int(float(value[:-1]) * 1024)
+    if value.endswith("M"):
+        return region, int(float(value[:-1]) * 1024 * 1024)
+    return region, int(value, 0)
+
+
+def build_report(regions, sections, elf):
+    """
+    Returns the report as a dictionary
+    """
+    loaded = {}
+    for section in elf.sections:
+        if section.flags & SHF_ALLOC:
+            loaded[section.name] = section.type != SHT_NOBITS
+
+    report_sections = {}
+    report_modules = {}
+
+    def count(region, section, module, size):
+        if region is None or size == 0:
+            return
+        region.used += size
+        by_region = report_sections.setdefault(section.name, {})
+        by_region[region.name] = by_region.get(region.name, 0) + size
+        entry = report_modules.setdefault(module, {})
+        by_section = entry.setdefault(section.name, {})
+        by_section[region.name] = by_section.get(region.name, 0) + size
+
+    for section in sections:
+        if section.name not in loaded or section.size == 0:
+            continue
+
+        # What isn't an input section is padding, and a section of padding
+        # only is a reserve, like the heap or the main stack
+        modules = dict(section.modules)
+        gap = section.size - sum(modules.values())
+        if gap > 0:
+            modules[FILL_MODULE] = modules.get(FILL_MODULE, 0) + gap
+        if set(modules) <= {FILL_MODULE}:
+            modules = {RESERVED_MODULE: section.size}
+
+        run = find_region(regions, section.addr)
+        load = None
+        if loaded[section.name] and section.load is not None and section.load != section.addr:
+            load = find_region(regions, section.load)
+
+        for module, size in modules.items():
+            count(run, section, module, size)
+            if load is not None and load is not run:
+                count(load, section, module, size)
+
+    return {
+        "regions": {
+            r.name: {"origin": r.origin, "length": r.length, "used": r.used}
+            for r in regions
+        },
+        "sections": report_sections,
+        "modules": report_modules,
+    }
+
+
+def format_text(report, budgets):
+    """
+    Returns the report as text tables
+    """
+    names = list(report["regions"])
+    lines = []
+
+    lines.append(f"{'region':<12} {'used':>10} {'size':>10} {'use':>7} {'budget':>10}")
+    for name, region in report["regions"].items():
+        budget = budgets.get(name)
+        use = 100.0 * region["used"] / region["length"] if region["length"] else 0.0
+        lines.append(f"{name:<12} {region['used']:>10} {region['length']:>10} "
+                     f"{use:>6.1f}% {budget if budget is not None else '-':>10}")
+
+    header = "".join(f" {name:>9}" for name in names)
+
+    lines.append("")
+    lines.append(f"{'section':<32}{header}")
+    for section in sorted(report["sections"]):
+        sizes = report["sections"][section]
+        lines.append(f"{section:<32}" + "".join(f" {sizes.get(n, 0):>9}" for n in names))
+
+    lines.append("")
+    lines.append(f"{'module':<32}{header}")
+    for module in sorted(report["modules"]):
+        sizes = {}
+        for by_region in report["modules"][module].values():
+            for name, size in by_region.items():
+                sizes[name] = sizes.get(name, 0) + size
+        lines.append(f"{module:<32}" + "".join(f" {sizes.get(n, 0):>9}" for n in names))
+
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    """
+    Program entry point
+    """
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--map", required=True, help="map file written by the linker")
+    parser.add_argument("--elf", required=True, help="the linked ELF file")
+    parser.add_argument("--json", metavar="FILE", help="write the report as JSON")
+    parser.add_argument("--text", metavar="FILE", help="write the report as text tables")
+    parser.add_argument("--budget", metavar="REGION=SIZE", action="append", default=[],
+                        help="fail if REGION uses more than SIZE, in bytes, K, M or %%")
+    args = parser.parse_args()
+
+    regions, sections = parse_map(args.map)
+    report = build_report(regions, sections, ElfFile(args.elf))
+
+    budgets = {}
+    for text in args.budget:
+        try:
+            region, size = parse_budget(text, regions)
+        except ValueError as error:
+            parser.error(str(error))
+        budgets[region.name] = size
+    report["budgets"] = budgets
+
+    text = format_text(report, budgets)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as file:
+            json.dump(report, file, indent=2, sort_keys=True)
+            file.write("\n")
+
+    if args.text:
+        with open(args.text, "w", encoding="utf-8") as file:
+            file.write(text)
+
+    # The regions only, the rest is in the files
+    print(text.split("\n\n", 1)[0])
+
+    failed = 0
+    for region in regions:
+        budget = budgets.get(region.name)
+        if budget is not None and region.used > budget:
+            print(f"[size_report] {region.name} uses {region.used} bytes, "
+                  f"{region.used - budget} over its budget of {budget}", file=sys.stderr)
+            failed += 1
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
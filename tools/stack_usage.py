@@ -0,0 +1,379 @@
+#!/usr/bin/env python3
+"""
+Compute the worst case stack usage of each task of application.elf.
+
+The build writes the stack frame of each function in a .su file next to its
+object file (-fstack-usage).  The call graph comes from the disassembly of
+the ELF file, so it follows the code as linked: inlined functions are part of
+their caller and the tail calls (b.w) are calls of the caller's caller.  The
+map file tells which object each function was linked from, for the static
+functions that have the same name in several files.
+
+The depth of a task is the deepest path from its entry point, plus the
+context saved on its stack when it's switched out.  The interrupts run on
+the main stack, not on the stack of the tasks.
+
+The depth is a lower bound when the tool can't see the whole graph, and the
+report says why for each task:
+
+  indirect   calls through a function pointer.  --edge CALLER=CALLEE adds the
+             functions a pointer may call.
+  unknown    functions without a .su file, e.g. the C library or assembly,
+             counted as 0 bytes.
+  dynamic    functions with alloca() or a variable length array.
+  recursion  a cycle in the graph, counted once.
+
+The stack of a task is given with its entry point, either as a number of
+bytes, the size of a symbol (a static stack buffer) or the stack_size field
+of an osThreadAttr_t:
+
+    --task log_task=m_log_task_attributes.stack_size
+    --task prvTimerTask=Timer_Stack
+    --task StartDefaultTask=512
+
+Example:
+
+    stack_usage.py --elf application.elf --map application.map \\
+        --su-dir build/Arm --task log_task=m_log_task_attributes.stack_size
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+from elf_file import ElfFile
+
+# Saved on the stack of a task by a context switch on the Cortex-M7 with its
+# FPU: the exception frame with the FPU registers and its alignment (27
+# words), and r4-r11, r14 and s16-s31 pushed by PendSV_Handler (25 words).
+DEFAULT_CONTEXT = (27 + 25) * 4
+
+# Offset of stack_size in osThreadAttr_t
+ATTR_STACK_SIZE = 20
+
+SU_LINE = re.compile(r"^(.*):(\d+):(\d+):(.+?)\t(\d+)\t(\S+)")
+FUNCTION = re.compile(r"^([0-9a-fA-F]+) <(.+)>:$")
+INSTRUCTION = re.compile(r"^\s*([0-9a-fA-F]+):\s+(\S+)\s*(.*)$")
+TARGET = re.compile(r"([0-9a-fA-F]+) <([^>+]+)(\+0x[0-9a-fA-F]+)?>")
+INPUT_SECTION = re.compile(r"^ \.(?:text|itcm_text)\S*\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+VENEER = re.compile(r"^__(.+)_veneer$")
+
+CONDITIONS = "(?:eq|ne|cs|cc|hs|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al)?"
+CALL = re.compile(rf"^(?:blx?{CONDITIONS}(?:\.[nw])?|callq?)$")
+BRANCH = re.compile(rf"^(?:b{CONDITIONS}(?:\.[nw])?|bx{CONDITIONS}|jmpq?)$")
+
+
+class Function:
+    """
+    A function of the ELF file and what it calls
+    """
+    def __init__(self, addr, name):
+        self.addr = addr
+        self.name = name
+        self.frame = None
+        self.dynamic = False
+        self.calls = set()
+        self.indirect = False
+
+
+def read_su(directories):
+    """
+    Returns { function: [(source, bytes, dynamic)] } from the .su files
+    """
+    frames = {}
+    for directory in directories:
+        for root, _, files in os.walk(directory):
+            for name in files:
+                if not name.endswith(".su"):
+                    continue
+
+                with open(os.path.join(root, name), encoding="utf-8") as file:
+                    for line in file:
+                        match = SU_LINE.match(line)
+                        if not match:
+                            continue
+                        source, _, _, function, size, qualifier = match.groups()
+                        frames.setdefault(function, []).append(
+                            (os.path.basename(source), int(size),
+                             qualifier.startswith("dynamic") and "bounded" not in qualifier))
+    return frames
+
+
+def read_objects(path):
+    """
+    Returns the sorted (address, size, source) of the code input sections of
+    a map file, the source is the name of the C file of the object
+    """
+    objects = []
+    if path is None:
+        return objects
+
+    with open(path, encoding="utf-8", errors="replace") as file:
+        for line in file:
+            match = INPUT_SECTION.match(line)
+            if match:
+                addr, size, source = match.groups()
+                source = source.strip().rstrip(")")
+                source = os.path.basename(source.split("(")[-1])
+                for suffix in (".obj", ".o"):
+                    if source.endswith(suffix):
+                        source = source[:-len(suffix)]
+                        break
+                objects.append((int(addr, 16), int(size, 16), source))
+
+    objects.sort()
+    return objects
+
+
+def source_of(objects, addr):
+    """
+    Returns the source file of the code at an address, or None
+    """
+    for start, size, source in objects:
+        if start <= addr < start + size:
+            return source
+    return None
+
+
+def read_calls(objdump, elf_path):
+    """
+    Returns { address: Function } from the disassembly of the ELF file
+    """
+    output = subprocess.run([objdump, "-d", "--no-show-raw-insn", elf_path],
+                            check=True, capture_output=True, text=True).stdout
+
+    functions = {}
+    current = None
+    for line in output.splitlines():
+        match = FUNCTION.match(line)
+        if match:
+            addr = int(match.group(1), 16)
+            current = functions.setdefault(addr, Function(addr, match.group(2)))
+            continue
+
+        match = INSTRUCTION.match(line)
+        if current is None or not match:
+            continue
+
+        mnemonic, operands = match.group(2), match.group(3)
+        is_call = CALL.match(mnemonic)
+        if not is_call and not BRANCH.match(mnemonic):
+            continue
+
+        target = TARGET.search(operands)
+        if target is None:
+            # Through a register, the return of bx lr isn't a call
+            if is_call or ("lr" not in operands and mnemonic.startswith(("bx", "jmp"))):
+                current.indirect = True
+            continue
+
+        # A branch inside the function isn't a call, one to the start of
+        # another function is a tail call
+        addr, name, offset = target.groups()
+        if name != current.name and (is_call or offset is None):
+            current.calls.add(int(addr, 16))
+
+    return functions
+
+
+def link(functions, frames, objects, edges):
+    """
+    Set the frame of each function and add the edges given by hand
+    """
+    by_name = {}
+    for function in functions.values():
+        by_name.setdefault(function.name, []).append(function)
+
+    for function in functions.values():
+        # A veneer jumps to the function it's named after
+        veneer = VENEER.match(function.name)
+        if veneer:
+            function.frame = 0
+            function.calls.update(f.addr for f in by_name.get(veneer.group(1), []))
+            continue
+
+        candidates = frames.get(function.name, [])
+        if len(candidates) > 1:
+            source = source_of(objects, function.addr)
+            candidates = [c for c in candidates if c[0] == source] or candidates
+        if candidates:
+            _, function.frame, function.dynamic = candidates[0]
+
+    for caller, callee in edges:
+        for function in by_name.get(caller, []):
+            function.calls.update(f.addr for f in by_name.get(callee, []))
+
+
+class Result:
+    """
+    Worst case depth from a function and what made it a lower bound
+    """
+    def __init__(self):
+        self.depth = 0
+        self.path = []
+        self.indirect = set()
+        self.unknown = set()
+        self.dynamic = set()
+        self.recursion = set()
+
+    def merge(self, other):
+        """
+        Add the lower bounds found under a callee
+        """
+        self.indirect |= other.indirect
+        self.unknown |= other.unknown
+        self.dynamic |= other.dynamic
+        self.recursion |= other.recursion
+
+
+def depth(functions, addr, results, active):
+    """
+    Returns the Result of the deepest path from a function
+    """
+    if addr in results:
+        return results[addr]
+
+    function = functions[addr]
+    result = Result()
+    active.add(addr)
+
+    deepest = None
+    for callee in sorted(function.calls):
+        if callee not in functions:
+            continue
+        if callee in active:
+            result.recursion.add(functions[callee].name)
+            continue
+        sub = depth(functions, callee, results, active)
+        result.merge(sub)
+        if deepest is None or sub.depth > deepest.depth:
+            deepest = sub
+
+    active.discard(addr)
+
+    frame = function.frame
+    if frame is None:
+        result.unknown.add(function.name)
+        frame = 0
+    if function.indirect:
+        result.indirect.add(function.name)
+    if function.dynamic:
+        result.dynamic.add(function.name)
+
+    result.depth = frame + (deepest.depth if deepest else 0)
+    result.path = [(function.name, frame)] + (deepest.path if deepest else [])
+
+    # A result that depends on a function being walked would be wrong from
+    # another caller
+    if not result.recursion:
+        results[addr] = result
+    return result
+
+
+def stack_size(elf, spec):
+    """
+    Returns the bytes of a stack given as a number, SYMBOL or SYMBOL.stack_size
+    """
+    try:
+        return int(spec, 0)
+    except ValueError:
+        pass
+
+    name, _, field = spec.partition(".")
+    if field and field != "stack_size":
+        raise ValueError(f"unknown field '{field}' in '{spec}'")
+
+    # Static variables inside a function have a suffix, e.g. Timer_Stack.1
+    symbol = next((s for s in elf.symbols if s.name == name), None) or \
+        next((s for s in elf.symbols if s.name.startswith(name + ".")), None)
+    if symbol is None:
+        raise ValueError(f"symbol '{name}' not found")
+
+    if not field:
+        return symbol.size
+
+    data = elf.read(symbol.value + ATTR_STACK_SIZE, 4)
+    if data is None or len(data) != 4:
+        raise ValueError(f"can't read {spec}")
+    return int.from_bytes(data, "little" if elf.endian == "<" else "big")
+
+
+def main():
+    """
+    Program entry point
+    """
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--elf", required=True, help="the linked ELF file")
+    parser.add_argument("--map", help="map file written by the linker")
+    parser.add_argument("--su-dir", metavar="DIR", action="append", required=True,
+                        help="directory searched for the .su files, may be repeated")
+    parser.add_argument("--task", metavar="FUNCTION=STACK", action="append", required=True,
+                        help="entry point of a task and its stack, may be repeated")
+    parser.add_argument("--edge", metavar="CALLER=CALLEE", action="append", default=[],
+                        help="a call through a function pointer, may be repeated")
+    parser.add_argument("--context", type=int, default=DEFAULT_CONTEXT,
+                        help=f"bytes saved by a context switch (default {DEFAULT_CONTEXT})")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump",
+                        help="objdump of the toolchain")
+    parser.add_argument("--verbose", action="store_true",
+                        help="print the deepest path and the lower bounds of each task")
+    args = parser.parse_args()
+
+    edges = []
+    for text in args.edge:
+        caller, _, callee = text.partition("=")
+        if not callee:
+            parser.error(f"bad edge '{text}'")
+        edges.append((caller, callee))
+
+    elf = ElfFile(args.elf)
+    functions = read_calls(args.objdump, args.elf)
+    link(functions, read_su(args.su_dir), read_objects(args.map), edges)
+
+    print(f"{'task':<24} {'stack':>7} {'depth':>7} {'context':>7} {'headroom':>9}  lower bound")
+
+    results = {}
+    overflow = 0
+    for text in args.task:
+        entry, _, spec = text.partition("=")
+        try:
+            size = stack_size(elf, spec)
+        except ValueError as error:
+            parser.error(str(error))
+
+        addr = next((f.addr for f in functions.values() if f.name == entry), None)
+        if addr is None:
+            print(f"[stack_usage] {entry} isn't in {args.elf}", file=sys.stderr)
+            overflow += 1
+            continue
+
+        result = depth(functions, addr, results, set())
+        headroom = size - result.depth - args.context
+        bounds = [name for name, found in (("indirect", result.indirect),
+                                           ("unknown", result.unknown),
+                                           ("dynamic", result.dynamic),
+                                           ("recursion", result.recursion)) if found]
+        print(f"{entry:<24} {size:>7} {result.depth:>7} {args.context:>7} {headroom:>9}  "
+              + (", ".join(bounds) or "-"))
+
+        if args.verbose:
+            for name, frame in result.path:
+                print(f"    {frame:>7}  {name}")
+            for label, names in (("indirect", result.indirect), ("unknown", result.unknown),
+                                 ("dynamic", result.dynamic), ("recursion", result.recursion)):
+                if names:
+                    print(f"    {label}: " + ", ".join(sorted(names)))
+
+        if headroom < 0:
+            print(f"[stack_usage] the stack of {entry} is {-headroom} bytes too small",
+                  file=sys.stderr)
+            overflow += 1
+
+    return 1 if overflow else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())